@@ -0,0 +1,115 @@
+// KernelBenchmarks.cpp : Benchmarks for the squared distance kernels and the spatial grid, on synthetic uniformly spread points.
+//
+
+#include "benchmark/benchmark.h"
+#include <random>
+#include <vector>
+#include "DistanceKernels.h"
+#include "SpatialGrid.h"
+
+static const float MapExtent = 1024.0f;
+
+static std::vector<float> RandomCoordinates(int count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> coord(0.0f, MapExtent);
+	std::vector<float> values(count);
+	for (int i = 0; i < count; i++)
+	{
+		values[i] = coord(rng);
+	}
+	return values;
+}
+
+//every point against a fixed batch of 64 candidate end points, the shape of one closeness round late in generation
+static void BM_ClosestCandidate(benchmark::State& state)
+{
+	int pointCount = (int)state.range(0);
+	int candidateCount = 64;
+	std::vector<float> px = RandomCoordinates(pointCount, 1);
+	std::vector<float> py = RandomCoordinates(pointCount, 2);
+	std::vector<float> ex = RandomCoordinates(candidateCount, 3);
+	std::vector<float> ey = RandomCoordinates(candidateCount, 4);
+	std::vector<int> ids(candidateCount);
+	for (int i = 0; i < candidateCount; i++)
+	{
+		ids[i] = i;
+	}
+	std::vector<float> bestDistSq(pointCount);
+	std::vector<int> bestIdx(pointCount);
+	const DistanceKernels& kernels = GetDistanceKernels();
+	state.SetLabel(kernels.name);
+	for (auto _ : state)
+	{
+		std::fill(bestDistSq.begin(), bestDistSq.end(), 1e30f);
+		std::fill(bestIdx.begin(), bestIdx.end(), -1);
+		kernels.ClosestCandidate(px.data(), py.data(), bestDistSq.data(), bestIdx.data(), pointCount, ex.data(), ey.data(), ids.data(), candidateCount);
+		benchmark::DoNotOptimize(bestIdx.data());
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)pointCount * candidateCount);
+}
+BENCHMARK(BM_ClosestCandidate)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_MarkBeyond(benchmark::State& state)
+{
+	int pointCount = (int)state.range(0);
+	std::vector<float> distSq = RandomCoordinates(pointCount, 5);
+	std::vector<unsigned char> alive(pointCount);
+	const DistanceKernels& kernels = GetDistanceKernels();
+	state.SetLabel(kernels.name);
+	for (auto _ : state)
+	{
+		kernels.MarkBeyond(distSq.data(), alive.data(), pointCount, 16.0f);
+		benchmark::DoNotOptimize(alive.data());
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)pointCount);
+}
+BENCHMARK(BM_MarkBeyond)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_SpatialGridBuild(benchmark::State& state)
+{
+	int entryCount = (int)state.range(0);
+	std::vector<float> x = RandomCoordinates(entryCount, 6);
+	std::vector<float> y = RandomCoordinates(entryCount, 7);
+	SpatialGrid grid(0.0f, 0.0f, MapExtent, MapExtent, 8.0f);
+	for (auto _ : state)
+	{
+		grid.Reset(8.0f);
+		for (int i = 0; i < entryCount; i++)
+		{
+			grid.Insert(i, glm::vec2(x[i], y[i]));
+		}
+		grid.Build();
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)entryCount);
+}
+BENCHMARK(BM_SpatialGridBuild)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_SpatialGridNearest(benchmark::State& state)
+{
+	int entryCount = (int)state.range(0);
+	int queryCount = 4096;
+	std::vector<float> x = RandomCoordinates(entryCount, 8);
+	std::vector<float> y = RandomCoordinates(entryCount, 9);
+	std::vector<float> qx = RandomCoordinates(queryCount, 10);
+	std::vector<float> qy = RandomCoordinates(queryCount, 11);
+	SpatialGrid grid(0.0f, 0.0f, MapExtent, MapExtent, 8.0f);
+	for (int i = 0; i < entryCount; i++)
+	{
+		grid.Insert(i, glm::vec2(x[i], y[i]));
+	}
+	grid.Build();
+	for (auto _ : state)
+	{
+		int found = 0;
+		for (int q = 0; q < queryCount; q++)
+		{
+			float bestDistSq = 1e30f;
+			int bestId = -1;
+			found += grid.Nearest(glm::vec2(qx[q], qy[q]), &bestDistSq, &bestId) ? 1 : 0;
+		}
+		benchmark::DoNotOptimize(found);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)queryCount);
+}
+BENCHMARK(BM_SpatialGridNearest)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,250 @@
+// MapBenchmarks.cpp : Benchmarks for MapLayer lookups, attraction point sampling and Voronoi construction, on synthetic maps.
+//
+
+#include "benchmark/benchmark.h"
+#include <random>
+#include <stdio.h>
+#include <vector>
+#include "MapImage.h"
+#include "MapLayer.h"
+#include "Random.h"
+#include "SamplingTable.h"
+#include "SyntheticMaps.h"
+#include "ThreadPool.h"
+#include "Voronoi.h"
+
+static const int MapSize = 1024;
+
+//one pool for every benchmark that builds layers or tables in parallel, so none of them time thread start up
+static ThreadPool* Pool()
+{
+	static ThreadPool pool(0);
+	return &pool;
+}
+
+static MapLayer* StreetLayer()
+{
+	static MapLayer layer(SyntheticStreetPixels(MapSize, MapSize), MapSize, MapSize, MAPTYPE_ROADS, Pool());
+	return &layer;
+}
+
+static MapLayer* HeightLayer()
+{
+	static MapLayer layer(SyntheticHeightPixels(MapSize, MapSize), MapSize, MapSize, MAPTYPE_HEIGHT, Pool());
+	return &layer;
+}
+
+static std::vector<glm::vec2> RandomPoints(int count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> coord(0.0f, (float)MapSize - 1.0f);
+	std::vector<glm::vec2> points(count);
+	for (int i = 0; i < count; i++)
+	{
+		points[i] = glm::vec2(coord(rng), coord(rng));
+	}
+	return points;
+}
+
+static void BM_RoadScaleFromColor(benchmark::State& state)
+{
+	MapLayer* layer = StreetLayer();
+	std::vector<glm::vec2> points = RandomPoints((int)state.range(0), 1);
+	for (auto _ : state)
+	{
+		float total = 0.0f;
+		for (auto& p : points)
+		{
+			total += layer->RoadScaleFactorFromColor(layer->ColorLookup((int)p.x, (int)p.y));
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_RoadScaleFromColor)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_RoadScaleLookup(benchmark::State& state)
+{
+	MapLayer* layer = StreetLayer();
+	std::vector<glm::vec2> points = RandomPoints((int)state.range(0), 1);
+	for (auto _ : state)
+	{
+		float total = 0.0f;
+		for (auto& p : points)
+		{
+			total += layer->RoadScaleLookup((int)p.x, (int)p.y);
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_RoadScaleLookup)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_AccessibilityBetweenPoints(benchmark::State& state)
+{
+	MapLayer* layer = StreetLayer();
+	std::vector<glm::vec2> points = RandomPoints((int)state.range(0), 2);
+	//segment length steps in a fixed direction, the shape of the queries made while growing
+	glm::vec2 step = glm::vec2(5.6f, 5.6f);
+	for (auto _ : state)
+	{
+		float total = 0.0f;
+		for (auto& p : points)
+		{
+			total += layer->AccessibilityBetweenPoints(p, p + step);
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_AccessibilityBetweenPoints)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_AccessibilityAlongLines(benchmark::State& state)
+{
+	MapLayer* roads = StreetLayer();
+	MapLayer* heights = HeightLayer();
+	std::vector<glm::vec2> starts = RandomPoints((int)state.range(0), 2);
+	std::vector<glm::vec2> ends(starts.size());
+	for (unsigned int i = 0; i < starts.size(); i++)
+	{
+		ends[i] = starts[i] + glm::vec2(5.6f, 5.6f);
+	}
+	std::vector<float> accessibility(starts.size());
+	for (auto _ : state)
+	{
+		roads->AccessibilityAlongLines(starts.data(), ends.data(), accessibility.data(), (int)starts.size(), heights, 0.25f);
+		benchmark::DoNotOptimize(accessibility.data());
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)starts.size());
+}
+BENCHMARK(BM_AccessibilityAlongLines)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_HeightLookup(benchmark::State& state)
+{
+	MapLayer* layer = HeightLayer();
+	std::vector<glm::vec2> points = RandomPoints((int)state.range(0), 3);
+	for (auto _ : state)
+	{
+		float total = 0.0f;
+		for (auto& p : points)
+		{
+			total += layer->HeightLookup((int)p.x, (int)p.y);
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_HeightLookup)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_MaximalSlope(benchmark::State& state)
+{
+	MapLayer* layer = HeightLayer();
+	std::vector<glm::vec2> points = RandomPoints((int)state.range(0), 4);
+	for (auto _ : state)
+	{
+		float total = 0.0f;
+		for (auto& p : points)
+		{
+			total += layer->MaxmimalSlope((int)p.x, (int)p.y);
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_MaximalSlope)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_HeightFieldBuild(benchmark::State& state)
+{
+	std::vector<GLubyte> pixels = SyntheticHeightPixels(MapSize, MapSize);
+	for (auto _ : state)
+	{
+		MapLayer layer(pixels, MapSize, MapSize, MAPTYPE_HEIGHT, Pool());
+		benchmark::DoNotOptimize(layer.MaxmimalSlope(0, 0));
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)MapSize * MapSize);
+}
+BENCHMARK(BM_HeightFieldBuild)->Unit(benchmark::kMillisecond);
+
+static void BM_GradientAt(benchmark::State& state)
+{
+	MapLayer* layer = HeightLayer();
+	std::vector<glm::vec2> points = RandomPoints((int)state.range(0), 8);
+	for (auto _ : state)
+	{
+		glm::vec2 total(0.0f, 0.0f);
+		for (auto& p : points)
+		{
+			total += layer->GradientAt(p);
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_GradientAt)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_MapLayerLoadRaw(benchmark::State& state)
+{
+	//the layer maps the file and builds its class raster, the pixels themselves are never copied
+	const char* path = "sca_benchmark_streets.raw";
+	std::vector<GLubyte> pixels = SyntheticStreetPixels(MapSize, MapSize);
+	if (!MapImage::WriteRaw(path, &pixels[0], MapSize, MapSize, 4, GL_RGBA))
+	{
+		state.SkipWithError("could not write the raw map");
+		return;
+	}
+	for (auto _ : state)
+	{
+		MapLayer layer(path, MapSize, MapSize, MAPTYPE_ROADS, Pool());
+		benchmark::DoNotOptimize(layer.RoadClassLookup(0, 0));
+	}
+	remove(path);
+	state.SetItemsProcessed(state.iterations() * (int64_t)MapSize * MapSize);
+}
+BENCHMARK(BM_MapLayerLoadRaw)->Unit(benchmark::kMillisecond);
+
+static void BM_VoronoiConstruction(benchmark::State& state)
+{
+	std::vector<glm::vec2> sites = RandomPoints((int)state.range(0), 5);
+	for (auto _ : state)
+	{
+		Voronoi* voro = new Voronoi(0.1f, sites, 0.0f, (float)MapSize - 1.0f, 0.0f, (float)MapSize - 1.0f);
+		benchmark::DoNotOptimize(voro);
+		state.PauseTiming();
+		delete voro;
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)sites.size());
+}
+BENCHMARK(BM_VoronoiConstruction)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_SamplingTableBuild(benchmark::State& state)
+{
+	MapLayer* layer = StreetLayer();
+	for (auto _ : state)
+	{
+		SamplingTable table(layer, false, Pool());
+		benchmark::DoNotOptimize(table.PassableCount());
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)MapSize * MapSize);
+}
+BENCHMARK(BM_SamplingTableBuild)->Unit(benchmark::kMillisecond);
+
+static void BM_SamplingTableSample(benchmark::State& state)
+{
+	SamplingTable table(StreetLayer(), true, Pool());
+	int sampleCount = (int)state.range(0);
+	Random random(1);
+	for (auto _ : state)
+	{
+		float total = 0.0f;
+		for (int i = 0; i < sampleCount; i++)
+		{
+			float roadScale;
+			glm::ivec2 pixel = table.Sample(&random, &roadScale);
+			total += roadScale + (float)pixel.x;
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)sampleCount);
+}
+BENCHMARK(BM_SamplingTableSample)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
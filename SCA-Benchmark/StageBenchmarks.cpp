@@ -0,0 +1,236 @@
+// StageBenchmarks.cpp : Benchmarks for each RoadNetwork generation stage in isolation, on synthetic maps.
+//
+
+#include "benchmark/benchmark.h"
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+#include "DynamicGrid.h"
+#include "MapLayer.h"
+#include "RoadNetwork.h"
+#include "SyntheticMaps.h"
+
+static const int MapSize = 1024;
+static const int WarmUpRounds = 30;	//rounds grown before timing, so the stages see a part grown network rather than the starting sites
+
+//Drives a RoadNetwork one stage at a time, and saves/restores the state the stages change so every iteration starts equal
+class RoadNetworkBenchmark
+{
+private:
+	//everything the stages modify, copied out of the network
+	class Snapshot
+	{
+	public:
+		SegmentPool segments;
+		AttractionPointSet attractionPoints;
+		std::vector<int> growthFrontier;
+		std::vector<int> newlyInfluenced;
+		std::vector<int> lastAdded;
+		std::unique_ptr<DynamicGrid> endIndex;	//exactly the ends indexed when the snapshot was taken
+		int totalConnectors;
+		Random random = Random(0);	//so every iteration samples the same streams
+	};
+	std::unique_ptr<MapLayer> heightLayer;
+	std::unique_ptr<MapLayer> streetLayer;
+	std::unique_ptr<RoadNetwork> network;
+	std::vector<int> lastAdded;
+	Snapshot initial, beforeCloseness, beforeKill, beforeGrowth, beforeConnection;
+
+	void Save(Snapshot* s)
+	{
+		s->segments = network->segments;
+		s->attractionPoints = network->attractionPoints;
+		s->growthFrontier = network->growthFrontier;
+		s->newlyInfluenced = network->newlyInfluenced;
+		s->lastAdded = lastAdded;
+		s->endIndex.reset(new DynamicGrid(*network->endIndex));
+		s->totalConnectors = network->totalConnectors;
+		s->random = *network->random;
+	}
+
+	void Restore(const Snapshot& s)
+	{
+		network->segments = s.segments;
+		network->attractionPoints = s.attractionPoints;
+		network->growthFrontier = s.growthFrontier;
+		network->newlyInfluenced = s.newlyInfluenced;
+		lastAdded = s.lastAdded;
+		*network->endIndex = *s.endIndex;
+		network->totalConnectors = s.totalConnectors;
+		*network->random = s.random;
+		//the chunk buffers aren't restored, each stage clears the ones it uses so they keep their capacity outside the timed region
+	}
+
+	//swaps the network's random attraction points for pointCount points from a fixed seed
+	void SeedAttractionPoints(int pointCount)
+	{
+		std::mt19937 rng(pointCount);
+		std::uniform_int_distribution<int> coord(0, MapSize - 1);
+		network->attractionPoints = AttractionPointSet();
+		while ((int)network->attractionPoints.Size() < pointCount)
+		{
+			int x = coord(rng);
+			int y = coord(rng);
+			float roadScale = streetLayer->RoadScaleLookup(x, y);
+			if (roadScale != IMPASSIBLE)
+			{
+				network->attractionPoints.Add(glm::vec2((float)x, (float)y), roadScale);
+			}
+		}
+	}
+
+public:
+	RoadNetworkBenchmark(int pointCount)
+	{
+		ThreadPool loadPool(generationThreadCount);
+		heightLayer.reset(new MapLayer(SyntheticHeightPixels(MapSize, MapSize), MapSize, MapSize, MAPTYPE_HEIGHT, &loadPool));
+		streetLayer.reset(new MapLayer(SyntheticStreetPixels(MapSize, MapSize), MapSize, MapSize, MAPTYPE_ROADS, &loadPool));
+		network.reset(new RoadNetwork(heightLayer.get(), streetLayer.get(), 1));
+		SeedAttractionPoints(pointCount);
+		Save(&initial);
+		for (int i = 0; i < network->segments.Size(); i++)
+		{
+			lastAdded.push_back(i);
+		}
+		for (int r = 0; r < WarmUpRounds; r++)
+		{
+			network->GenerationRound(&lastAdded);
+		}
+		//capture the input to each stage of the next round
+		Save(&beforeCloseness);
+		network->GenerateClosenessNetwork(&lastAdded);
+		Save(&beforeKill);
+		network->KillPointsNearSegments();
+		Save(&beforeGrowth);
+		//and a finished network for the connection pass
+		unsigned int remaining = network->attractionPoints.Size();
+		int noProgressCount = 0;
+		network->AddNewSegmentSet(&lastAdded);
+		while (network->attractionPoints.Size() > 1 && noProgressCount < 20)
+		{
+			network->GenerationRound(&lastAdded);
+			noProgressCount = network->attractionPoints.Size() == remaining ? noProgressCount + 1 : 0;
+			remaining = network->attractionPoints.Size();
+		}
+		Save(&beforeConnection);
+	}
+
+	void Closeness(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Restore(beforeCloseness);
+			state.ResumeTiming();
+			network->GenerateClosenessNetwork(&lastAdded);
+		}
+		state.counters["points"] = (double)beforeCloseness.attractionPoints.Size();
+		state.counters["candidates"] = (double)beforeCloseness.lastAdded.size();
+	}
+
+	void Kill(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Restore(beforeKill);
+			state.ResumeTiming();
+			network->KillPointsNearSegments();
+		}
+		state.counters["points"] = (double)beforeKill.attractionPoints.Size();
+	}
+
+	void Growth(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Restore(beforeGrowth);
+			state.ResumeTiming();
+			network->AddNewSegmentSet(&lastAdded);
+		}
+		state.counters["frontier"] = (double)(beforeGrowth.growthFrontier.size() + beforeGrowth.newlyInfluenced.size());
+	}
+
+	//a whole growth phase from the starting sites, either as one network or split into a region per site
+	void Grow(benchmark::State& state, bool byRegion)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Restore(initial);
+			state.ResumeTiming();
+			if (byRegion)
+			{
+				network->GrowRegions();
+			}
+			else
+			{
+				network->GrowNetwork();
+			}
+		}
+		state.counters["segments"] = (double)network->segments.Size();
+	}
+
+	void Connection(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Restore(beforeConnection);
+			state.ResumeTiming();
+			network->PostGenerationConnection();
+		}
+		state.counters["segments"] = (double)beforeConnection.segments.Size();
+	}
+};
+
+//building a fixture grows a whole network, so each size is built once and shared by every stage and repetition
+static RoadNetworkBenchmark* Fixture(int pointCount)
+{
+	static std::map<int, std::unique_ptr<RoadNetworkBenchmark>> fixtures;
+	std::unique_ptr<RoadNetworkBenchmark>& f = fixtures[pointCount];
+	if (!f)
+	{
+		f.reset(new RoadNetworkBenchmark(pointCount));
+	}
+	return f.get();
+}
+
+static void BM_GenerateClosenessNetwork(benchmark::State& state)
+{
+	Fixture((int)state.range(0))->Closeness(state);
+}
+
+static void BM_KillPointsNearSegments(benchmark::State& state)
+{
+	Fixture((int)state.range(0))->Kill(state);
+}
+
+static void BM_AddNewSegmentSet(benchmark::State& state)
+{
+	Fixture((int)state.range(0))->Growth(state);
+}
+
+static void BM_GrowNetwork(benchmark::State& state)
+{
+	Fixture((int)state.range(0))->Grow(state, false);
+}
+
+static void BM_GrowRegions(benchmark::State& state)
+{
+	Fixture((int)state.range(0))->Grow(state, true);
+}
+
+static void BM_PostGenerationConnection(benchmark::State& state)
+{
+	Fixture((int)state.range(0))->Connection(state);
+}
+
+BENCHMARK(BM_GenerateClosenessNetwork)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_KillPointsNearSegments)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AddNewSegmentSet)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GrowNetwork)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GrowRegions)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PostGenerationConnection)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
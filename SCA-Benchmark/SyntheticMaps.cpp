@@ -0,0 +1,60 @@
+#include "SyntheticMaps.h"
+#include <cmath>
+
+static void SetPixel(std::vector<GLubyte>* pixels, int width, int x, int y, GLubyte r, GLubyte g, GLubyte b)
+{
+	int pidx = 4 * (x + width * y);
+	(*pixels)[pidx] = r;
+	(*pixels)[pidx + 1] = g;
+	(*pixels)[pidx + 2] = b;
+	(*pixels)[pidx + 3] = 255;
+}
+
+std::vector<GLubyte> SyntheticStreetPixels(int width, int height)
+{
+	std::vector<GLubyte> pixels(4 * width * height);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			//colours match the classes MapLayer::RoadClassFromColor recognises
+			if (x % 256 < 3 || y % 256 < 3)
+			{
+				SetPixel(&pixels, width, x, y, 0, 255, 255);	//motorway
+			}
+			else if (x % 64 < 2 || y % 64 < 2)
+			{
+				SetPixel(&pixels, width, x, y, 0, 200, 0);	//major
+			}
+			else if (x % 32 == 0 || y % 32 == 0)
+			{
+				SetPixel(&pixels, width, x, y, 255, 0, 0);	//minor
+			}
+			else if ((x / 32 + y / 32) % 7 == 0 && x % 32 > 8 && y % 32 > 8)
+			{
+				SetPixel(&pixels, width, x, y, 200, 175, 150);	//impassable
+			}
+			else
+			{
+				SetPixel(&pixels, width, x, y, 255, 255, 255);	//no road
+			}
+		}
+	}
+	return pixels;
+}
+
+std::vector<GLubyte> SyntheticHeightPixels(int width, int height)
+{
+	std::vector<GLubyte> pixels(4 * width * height);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float h = 0.5f + 0.3f * sinf(x / 97.0f) * cosf(y / 61.0f) + 0.1f * sinf((x + y) / 37.0f);
+			GLubyte v = (GLubyte)(1.0f + 254.0f * h);
+			SetPixel(&pixels, width, x, y, v, v, v);
+			pixels[4 * (x + width * y) + 3] = v;
+		}
+	}
+	return pixels;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <vector>
+
+//Procedural stand-ins for the real map layers, built in memory so benchmark inputs are identical on every machine and
+//don't depend on data files. Both are 4 bytes per pixel in RGBA order, as the in-memory MapLayer constructor takes them.
+//Targas load as BGRA instead, and MapLayer reads either through its channel offsets
+
+//white open ground crossed by a grid of motorways, major and minor roads, with a scattering of impassable blocks
+std::vector<GLubyte> SyntheticStreetPixels(int width, int height);
+//smooth rolling hills, stored in every channel so both the colour and alpha based lookups see the same surface
+std::vector<GLubyte> SyntheticHeightPixels(int width, int height);
@@ -0,0 +1,90 @@
+// SCA-Generator.cpp : Generates a road network without opening a window or creating a GL context, and writes the result to disk.
+//
+
+#include "time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MapImage.h"
+#include "MapLayer.h"
+#include "RoadNetwork.h"
+
+void printUsage(const char* program)
+{
+	printf("Usage: %s <heightmap> <streetmap> <output.csv> [width] [height] [seed]\n", program);
+	printf("Width and height default to 1024, the seed defaults to the current time\n");
+	printf("       %s --convert <map.tga> <map.raw>\n", program);
+	printf("Converts a targa to the raw map format, which is used in place without any decoding\n");
+}
+
+int convertMap(const char* inPath, const char* outPath)
+{
+	MapImage image;
+	if (!image.Open(inPath))
+	{
+		return -1;
+	}
+	if (!MapImage::WriteRaw(outPath, image.GetPixels(), image.GetWidth(), image.GetHeight(), image.GetComponents(), image.GetFormat()))
+	{
+		printf("Could not write %s\n", outPath);
+		return -1;
+	}
+	printf("%s converted to %s\n", inPath, outPath);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 4 && strcmp(argv[1], "--convert") == 0)
+	{
+		return convertMap(argv[2], argv[3]);
+	}
+	if (argc < 4)
+	{
+		printUsage(argv[0]);
+		return -1;
+	}
+	int width = argc > 4 ? atoi(argv[4]) : 1024;
+	int height = argc > 5 ? atoi(argv[5]) : 1024;
+	uint64_t seed = argc > 6 ? strtoull(argv[6], nullptr, 10) : (uint64_t)time(NULL);
+	if (width <= 0 || height <= 0)
+	{
+		printUsage(argv[0]);
+		return -1;
+	}
+
+	//load the map data, with the same number of threads generation is allowed
+	ThreadPool loadPool(generationThreadCount);
+	MapLayer* heightLayer = new MapLayer(argv[1], width, height, MAPTYPE_HEIGHT, &loadPool);
+	MapLayer* streetLayer = new MapLayer(argv[2], width, height, MAPTYPE_ROADS, &loadPool);
+	if (!heightLayer->IsLoaded() || !streetLayer->IsLoaded())
+	{
+		delete heightLayer;
+		delete streetLayer;
+		return -1;
+	}
+
+	//generate the network
+	printf("Generating with seed %llu\n", (unsigned long long)seed);
+	int sTime = (int)time(NULL);
+	RoadNetwork* network = new RoadNetwork(heightLayer, streetLayer, seed);
+	network->GenerateNetwork();
+	int tTime = (int)time(NULL) - sTime;
+	printf("Generation time: %i\n", tTime);
+
+	int result = 0;
+	if (network->WriteSegments(argv[3]))
+	{
+		printf("Network written to %s\n", argv[3]);
+	}
+	else
+	{
+		printf("Could not write network to %s\n", argv[3]);
+		result = -1;
+	}
+
+	delete network;
+	delete heightLayer;
+	delete streetLayer;
+	return result;
+}
@@ -0,0 +1,25 @@
+#version 330
+
+precision highp float;
+
+//one instance per marker, expanded to a square of side size centred on position
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec4 color;
+layout (location = 2) in float size;
+
+uniform mat4 projectionViewMatrix;
+uniform mat4 modelMatrix;
+
+out Fragment
+{
+	vec4 color;
+} fragment;
+
+void main(void)
+{
+	fragment.color = color;
+	//corners in triangle strip order: (0, 0), (1, 0), (0, 1), (1, 1)
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) - 0.5;
+	vec4 newPos = modelMatrix * vec4(position + corner * size, 0.0, 1.0);
+	gl_Position = projectionViewMatrix * newPos;
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "DistanceKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCA_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SCA_TARGET(t)
+#else
+#include <cpuid.h>
+#define SCA_TARGET(t) __attribute__((target(t)))
+#endif
+#endif
+
+//Note: dx * dx + dy * dy is always evaluated as two multiplies and an add (never a fused multiply-add) so the scalar
+//and vector versions round identically. Builds must not enable floating point contraction for this file
+
+static void ClosestCandidateScalar(const float* px, const float* py, float* bestDistSq, int* bestIdx, int pointCount,
+	const float* ex, const float* ey, const int* ids, int candidateCount)
+{
+	for (int i = 0; i < pointCount; i++)
+	{
+		float best = bestDistSq[i];
+		int idx = bestIdx[i];
+		for (int c = 0; c < candidateCount; c++)
+		{
+			float dx = px[i] - ex[c];
+			float dy = py[i] - ey[c];
+			float d = dx * dx + dy * dy;
+			if (d < best)
+			{
+				best = d;
+				idx = ids[c];
+			}
+		}
+		bestDistSq[i] = best;
+		bestIdx[i] = idx;
+	}
+}
+
+static void MarkBeyondScalar(const float* distSq, unsigned char* alive, int count, float thresholdSq)
+{
+	for (int i = 0; i < count; i++)
+	{
+		alive[i] = distSq[i] > thresholdSq ? 1 : 0;
+	}
+}
+
+#ifdef SCA_X86
+
+SCA_TARGET("sse4.1") static void ClosestCandidateSSE4(const float* px, const float* py, float* bestDistSq, int* bestIdx, int pointCount,
+	const float* ex, const float* ey, const int* ids, int candidateCount)
+{
+	int i = 0;
+	//two groups of 4 per batch of 8, keeps the candidate loads shared between them
+	for (; i + 8 <= pointCount; i += 8)
+	{
+		__m128 x0 = _mm_loadu_ps(px + i), x1 = _mm_loadu_ps(px + i + 4);
+		__m128 y0 = _mm_loadu_ps(py + i), y1 = _mm_loadu_ps(py + i + 4);
+		__m128 b0 = _mm_loadu_ps(bestDistSq + i), b1 = _mm_loadu_ps(bestDistSq + i + 4);
+		__m128 i0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(bestIdx + i)));
+		__m128 i1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(bestIdx + i + 4)));
+		for (int c = 0; c < candidateCount; c++)
+		{
+			__m128 cx = _mm_set1_ps(ex[c]);
+			__m128 cy = _mm_set1_ps(ey[c]);
+			__m128 cid = _mm_castsi128_ps(_mm_set1_epi32(ids[c]));
+			__m128 dx0 = _mm_sub_ps(x0, cx), dy0 = _mm_sub_ps(y0, cy);
+			__m128 dx1 = _mm_sub_ps(x1, cx), dy1 = _mm_sub_ps(y1, cy);
+			__m128 d0 = _mm_add_ps(_mm_mul_ps(dx0, dx0), _mm_mul_ps(dy0, dy0));
+			__m128 d1 = _mm_add_ps(_mm_mul_ps(dx1, dx1), _mm_mul_ps(dy1, dy1));
+			__m128 m0 = _mm_cmplt_ps(d0, b0), m1 = _mm_cmplt_ps(d1, b1);
+			b0 = _mm_blendv_ps(b0, d0, m0);
+			b1 = _mm_blendv_ps(b1, d1, m1);
+			i0 = _mm_blendv_ps(i0, cid, m0);
+			i1 = _mm_blendv_ps(i1, cid, m1);
+		}
+		_mm_storeu_ps(bestDistSq + i, b0);
+		_mm_storeu_ps(bestDistSq + i + 4, b1);
+		_mm_storeu_si128((__m128i*)(bestIdx + i), _mm_castps_si128(i0));
+		_mm_storeu_si128((__m128i*)(bestIdx + i + 4), _mm_castps_si128(i1));
+	}
+	ClosestCandidateScalar(px + i, py + i, bestDistSq + i, bestIdx + i, pointCount - i, ex, ey, ids, candidateCount);
+}
+
+SCA_TARGET("sse4.1") static void MarkBeyondSSE4(const float* distSq, unsigned char* alive, int count, float thresholdSq)
+{
+	int i = 0;
+	__m128 t = _mm_set1_ps(thresholdSq);
+	for (; i + 8 <= count; i += 8)
+	{
+		int m0 = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(distSq + i), t));
+		int m1 = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(distSq + i + 4), t));
+		int m = m0 | (m1 << 4);
+		for (int b = 0; b < 8; b++)
+		{
+			alive[i + b] = (m >> b) & 1;
+		}
+	}
+	MarkBeyondScalar(distSq + i, alive + i, count - i, thresholdSq);
+}
+
+SCA_TARGET("avx2") static void ClosestCandidateAVX2(const float* px, const float* py, float* bestDistSq, int* bestIdx, int pointCount,
+	const float* ex, const float* ey, const int* ids, int candidateCount)
+{
+	int i = 0;
+	for (; i + 8 <= pointCount; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(px + i);
+		__m256 y = _mm256_loadu_ps(py + i);
+		__m256 best = _mm256_loadu_ps(bestDistSq + i);
+		__m256 idx = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(bestIdx + i)));
+		for (int c = 0; c < candidateCount; c++)
+		{
+			__m256 dx = _mm256_sub_ps(x, _mm256_set1_ps(ex[c]));
+			__m256 dy = _mm256_sub_ps(y, _mm256_set1_ps(ey[c]));
+			__m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			__m256 closer = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+			best = _mm256_blendv_ps(best, d, closer);
+			idx = _mm256_blendv_ps(idx, _mm256_castsi256_ps(_mm256_set1_epi32(ids[c])), closer);
+		}
+		_mm256_storeu_ps(bestDistSq + i, best);
+		_mm256_storeu_si256((__m256i*)(bestIdx + i), _mm256_castps_si256(idx));
+	}
+	ClosestCandidateScalar(px + i, py + i, bestDistSq + i, bestIdx + i, pointCount - i, ex, ey, ids, candidateCount);
+}
+
+SCA_TARGET("avx2") static void MarkBeyondAVX2(const float* distSq, unsigned char* alive, int count, float thresholdSq)
+{
+	int i = 0;
+	__m256 t = _mm256_set1_ps(thresholdSq);
+	for (; i + 8 <= count; i += 8)
+	{
+		int m = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(distSq + i), t, _CMP_GT_OQ));
+		for (int b = 0; b < 8; b++)
+		{
+			alive[i + b] = (m >> b) & 1;
+		}
+	}
+	MarkBeyondScalar(distSq + i, alive + i, count - i, thresholdSq);
+}
+
+static bool CPUSupports(bool avx2)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	if (!avx2)
+	{
+		return (info[2] & (1 << 19)) != 0;	//SSE4.1
+	}
+	//AVX2 also needs the OS to save the YMM registers (OSXSAVE set and XCR0 bits 1 and 2)
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6 || maxLeaf < 7)
+	{
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return avx2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+#endif
+
+static DistanceKernels SelectDistanceKernels()
+{
+	DistanceKernels k = { "scalar", ClosestCandidateScalar, MarkBeyondScalar };
+#ifdef SCA_X86
+	if (CPUSupports(true))
+	{
+		k = { "avx2", ClosestCandidateAVX2, MarkBeyondAVX2 };
+	}
+	else if (CPUSupports(false))
+	{
+		k = { "sse4.1", ClosestCandidateSSE4, MarkBeyondSSE4 };
+	}
+#endif
+	return k;
+}
+
+const DistanceKernels& GetDistanceKernels()
+{
+	static DistanceKernels kernels = SelectDistanceKernels();
+	return kernels;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+//Squared distance kernels for the closeness and kill passes. Everything works on squared distances, since only the
+//ordering of distances (or a compare against a squared threshold) is ever needed. Each kernel processes points 8 at a
+//time using AVX2 or SSE4.1 where the CPU has them, with a scalar fallback, and all versions give identical results
+struct DistanceKernels
+{
+	const char* name;
+	//For every point, checks each candidate end point in order and replaces (bestDistSq, bestIdx) with the candidate's
+	//squared distance and id whenever it is strictly closer, so ties keep the earlier candidate
+	void (*ClosestCandidate)(const float* px, const float* py, float* bestDistSq, int* bestIdx, int pointCount,
+		const float* ex, const float* ey, const int* ids, int candidateCount);
+	//alive[i] = 1 if distSq[i] > thresholdSq, otherwise 0
+	void (*MarkBeyond)(const float* distSq, unsigned char* alive, int count, float thresholdSq);
+};
+
+const DistanceKernels& GetDistanceKernels();	//the widest implementation this CPU supports, chosen on the first call
@@ -0,0 +1,66 @@
+#include "DynamicGrid.h"
+
+DynamicGrid::DynamicGrid(float minX, float minY, float maxX, float maxY, float cellSize)
+{
+	this->minX = minX;
+	this->minY = minY;
+	this->cellSize = cellSize;
+	cellsX = std::max(1, (int)ceil((maxX - minX) / cellSize));
+	cellsY = std::max(1, (int)ceil((maxY - minY) / cellSize));
+	cellIds.resize(cellsX * cellsY);
+	cellPositions.resize(cellsX * cellsY);
+}
+
+void DynamicGrid::Clear()
+{
+	for (auto& ids : cellIds)
+	{
+		ids.clear();
+	}
+	for (auto& positions : cellPositions)
+	{
+		positions.clear();
+	}
+}
+
+int DynamicGrid::CellX(float x)
+{
+	//anything outside the grid is clamped into the border cells
+	int cx = (int)floor((x - minX) / cellSize);
+	return std::min(std::max(cx, 0), cellsX - 1);
+}
+
+int DynamicGrid::CellY(float y)
+{
+	int cy = (int)floor((y - minY) / cellSize);
+	return std::min(std::max(cy, 0), cellsY - 1);
+}
+
+void DynamicGrid::Insert(int id, glm::vec2 pos)
+{
+	int cidx = CellX(pos.x) + cellsX * CellY(pos.y);
+	cellIds[cidx].push_back(id);
+	cellPositions[cidx].push_back(pos);
+}
+
+void DynamicGrid::QueryRadius(glm::vec2 pos, float radius, std::vector<int>* ids)
+{
+	int x0 = CellX(pos.x - radius), x1 = CellX(pos.x + radius);
+	int y0 = CellY(pos.y - radius), y1 = CellY(pos.y + radius);
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			int cidx = x + cellsX * y;
+			const std::vector<glm::vec2>& positions = cellPositions[cidx];
+			for (unsigned int i = 0; i < positions.size(); i++)
+			{
+				glm::vec2 offset = pos - positions[i];
+				if (glm::dot(offset, offset) < radius * radius)
+				{
+					ids->push_back(cellIds[cidx][i]);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//Uniform grid that entries can be added to at any time, for indexes that grow a little every round (such as the end of
+//every segment in a network). Each cell keeps its own arrays, so an insert is O(1) with no rebuild, and a radius query
+//only walks the cells it overlaps. SpatialGrid is the better choice when the whole set is rebuilt before each search
+class DynamicGrid
+{
+private:
+	float minX, minY;
+	float cellSize;
+	int cellsX, cellsY;
+	std::vector<std::vector<int>> cellIds;
+	std::vector<std::vector<glm::vec2>> cellPositions;	//kept alongside the ids so a search doesn't have to chase the owning object
+	int CellX(float x);
+	int CellY(float y);
+public:
+	DynamicGrid(float minX, float minY, float maxX, float maxY, float cellSize);
+	void Clear();
+	void Insert(int id, glm::vec2 pos);
+	void QueryRadius(glm::vec2 pos, float radius, std::vector<int>* ids);	//appends the id of every entry strictly within radius of pos
+};
@@ -0,0 +1,190 @@
+#include "GenerationWorker.h"
+
+SnapshotQueue::SnapshotQueue()
+{
+	head = 0;
+	tail = 0;
+	for (int i = 0; i < Capacity; i++)
+	{
+		slots[i] = nullptr;
+	}
+}
+
+SnapshotQueue::~SnapshotQueue()
+{
+	while (TryPop())
+	{
+	}
+}
+
+bool SnapshotQueue::TryPush(std::unique_ptr<NetworkSnapshot>& snapshot)
+{
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) == Capacity)
+	{
+		return false;
+	}
+	slots[t % Capacity] = snapshot.release();
+	tail.store(t + 1, std::memory_order_release);	//publishes the slot, and the snapshot it points to, to the consumer
+	return true;
+}
+
+std::unique_ptr<NetworkSnapshot> SnapshotQueue::TryPop()
+{
+	unsigned int h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire))
+	{
+		return std::unique_ptr<NetworkSnapshot>();
+	}
+	std::unique_ptr<NetworkSnapshot> snapshot(slots[h % Capacity]);
+	head.store(h + 1, std::memory_order_release);	//hands the slot back to the producer
+	return snapshot;
+}
+
+GenerationWorker::GenerationWorker(MapLayer* height, MapLayer* streets)
+{
+	heightLayer = height;
+	streetLayer = streets;
+	requested.seed = 0;
+	requested.streamRounds = true;
+	requestedRun = 0;
+	currentRun = 0;
+	stopping = false;
+	cancelRequested = false;
+	worker = std::thread(&GenerationWorker::WorkerLoop, this);
+}
+
+GenerationWorker::~GenerationWorker()
+{
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		stopping = true;
+		cancelRequested = true;
+	}
+	requestReady.notify_all();
+	worker.join();
+}
+
+int GenerationWorker::Restart(GenerationParameters parameters)
+{
+	int run;
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		requested = parameters;
+		run = ++requestedRun;
+		cancelRequested = true;
+	}
+	requestReady.notify_all();
+	return run;
+}
+
+void GenerationWorker::Cancel()
+{
+	cancelRequested = true;
+}
+
+std::unique_ptr<NetworkSnapshot> GenerationWorker::TakeSnapshot()
+{
+	return snapshots.TryPop();
+}
+
+void GenerationWorker::WorkerLoop()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	while (true)
+	{
+		requestReady.wait(guard, [&] { return stopping || requestedRun != currentRun; });
+		if (stopping)
+		{
+			return;
+		}
+		//only the latest request is run, any restarts made while the last run was stopping are skipped
+		currentRun = requestedRun;
+		GenerationParameters parameters = requested;
+		cancelRequested = false;
+		guard.unlock();
+		Generate(parameters, currentRun);
+		guard.lock();
+	}
+}
+
+void GenerationWorker::Generate(GenerationParameters parameters, int run)
+{
+	printf("Generating with seed %llu\n", (unsigned long long)parameters.seed);
+	RoadNetwork* network = new RoadNetwork(heightLayer, streetLayer, parameters.seed, &cancelRequested);
+	pending.reset(new NetworkSnapshot());
+	pending->run = run;
+	pending->firstSegment = 0;
+	pending->finished = false;
+	AttractionPointSet& points = *network->GetAttractionPoints();
+	for (unsigned int i = 0; i < points.Size(); i++)
+	{
+		pending->attractionPoints.push_back(points.Location(i));
+	}
+	pending->startingLocations = network->startingLocations;
+	if (parameters.streamRounds)
+	{
+		AddToPending(network, run, 0);
+		network->SetRoundCallback([&](int firstChanged)
+		{
+			AddToPending(network, run, firstChanged);
+			snapshots.TryPush(pending);	//if the render loop has fallen behind, the next round is added to this one instead
+		});
+	}
+	network->GenerateNetwork();
+	if (parameters.streamRounds)
+	{
+		AddToPending(network, run, network->GetSegments()->Size());
+	}
+	else
+	{
+		//nothing has been copied out, the render loop builds the whole mesh straight from the network's segments
+		pending->network.reset(network);
+		network = nullptr;
+	}
+	pending->finished = true;
+	//the last snapshot can't be coalesced with anything, so wait for room unless the worker is shutting down
+	while (!snapshots.TryPush(pending))
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		if (stopping)
+		{
+			pending.reset();
+			break;
+		}
+		guard.unlock();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	delete network;
+}
+
+void GenerationWorker::AddToPending(RoadNetwork* network, int run, int firstChanged)
+{
+	SegmentPool& segments = *network->GetSegments();
+	if (!pending)
+	{
+		pending.reset(new NetworkSnapshot());
+		pending->run = run;
+		pending->firstSegment = firstChanged;
+		pending->finished = false;
+	}
+	//drop anything already pending that has since changed, then add everything from there on
+	int pendingEnd = pending->firstSegment + pending->vertices.size() / 2;
+	int from = std::min(firstChanged, pendingEnd);
+	if (from < pending->firstSegment)
+	{
+		pending->firstSegment = from;
+		pending->vertices.clear();
+	}
+	else
+	{
+		pending->vertices.resize(2 * (from - pending->firstSegment), Vertex(glm::vec2(0.0f), glm::vec4(0.0f)));
+	}
+	int count = segments.Size() - from;
+	if (count > 0)
+	{
+		size_t offset = pending->vertices.size();
+		pending->vertices.resize(offset + 2 * count, Vertex(glm::vec2(0.0f), glm::vec4(0.0f)));
+		NetworkRenderer::FillLineVertices(segments, from, segments.Size(), pending->vertices.data() + offset);
+	}
+}
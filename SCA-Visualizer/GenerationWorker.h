@@ -0,0 +1,78 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "MapLayer.h"
+#include "NetworkRenderer.h"
+#include "RoadNetwork.h"
+#include "Vertex.h"
+
+//What a generation run is started with. The rest of the settings are the RoadNetwork statics
+struct GenerationParameters
+{
+	uint64_t seed;
+	bool streamRounds;	//publish every round's segments, otherwise only the finished network
+};
+
+//What a run has grown since the last snapshot, handed from the generating thread to the render loop and never changed once published
+struct NetworkSnapshot
+{
+	int run;	//the run it belongs to, from Restart
+	int firstSegment;	//the line mesh from this segment on is replaced by vertices
+	std::vector<Vertex> vertices;	//two per segment
+	std::vector<glm::vec2> attractionPoints;	//the first snapshot of a run only, the points before generation consumes them
+	std::vector<glm::vec2> startingLocations;	//the first snapshot of a run only
+	bool finished;	//the last snapshot of the run, which has either finished or been cancelled
+	std::unique_ptr<RoadNetwork> network;	//the last snapshot of a run that doesn't stream its rounds, handed over whole for NetworkRenderer::ConstructMesh
+};
+
+//Lock-free single producer, single consumer ring of snapshots. Neither side ever waits: pushing fails when it is full and
+//popping fails when it is empty
+class SnapshotQueue
+{
+private:
+	static const int Capacity = 64;
+	NetworkSnapshot* slots[Capacity];
+	std::atomic<unsigned int> head;	//next slot to pop, only written by the consumer
+	std::atomic<unsigned int> tail;	//next slot to push, only written by the producer
+public:
+	SnapshotQueue();
+	~SnapshotQueue();
+	bool TryPush(std::unique_ptr<NetworkSnapshot>& snapshot);	//producer only, takes the snapshot if there is room
+	std::unique_ptr<NetworkSnapshot> TryPop();	//consumer only, empty if there is nothing to take
+};
+
+//Runs RoadNetwork generation on its own thread so the render loop keeps going. Each run publishes snapshots of what it has
+//grown through a SnapshotQueue, coalescing rounds while the queue is full. Runs can be cancelled or restarted at any time
+class GenerationWorker
+{
+private:
+	MapLayer* heightLayer;
+	MapLayer* streetLayer;
+	SnapshotQueue snapshots;
+	std::thread worker;
+	std::mutex lock;	//guards the request below, only ever held briefly
+	std::condition_variable requestReady;
+	GenerationParameters requested;
+	int requestedRun;
+	int currentRun;
+	bool stopping;
+	std::atomic<bool> cancelRequested;	//read by the network every round
+	std::unique_ptr<NetworkSnapshot> pending;	//built up on the worker thread until there is room to publish it
+	void WorkerLoop();
+	void Generate(GenerationParameters parameters, int run);
+	void AddToPending(RoadNetwork* network, int run, int firstChanged);
+public:
+	GenerationWorker(MapLayer* height, MapLayer* streets);	//the layers must outlive the worker
+	~GenerationWorker();	//cancels the current run and waits for it to stop
+	int Restart(GenerationParameters parameters);	//cancels the current run, if any, and starts a new one. Returns its run number
+	void Cancel();	//stops the current run after the round in progress
+	std::unique_ptr<NetworkSnapshot> TakeSnapshot();	//the oldest unread snapshot, or empty, without blocking
+};
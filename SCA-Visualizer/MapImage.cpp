@@ -0,0 +1,151 @@
+#include "MapImage.h"
+
+static const char RawMapMagic[4] = { 'S', 'C', 'A', 'M' };
+
+MapImage::MapImage()
+{
+	pixels = nullptr;
+	width = 0;
+	height = 0;
+	components = 0;
+	format = GL_RGBA;
+}
+
+bool MapImage::Open(const char* path)
+{
+	pixels = nullptr;
+	if (!file.Open(path))
+	{
+		printf("Could not open %s\n", path);
+		return false;
+	}
+	bool opened = file.Size() >= sizeof(RAWMAPHEADER) && memcmp(file.Data(), RawMapMagic, 4) == 0 ? OpenRaw() : OpenTGA();
+	if (!opened)
+	{
+		printf("%s is not an uncompressed 8, 24 or 32 bit targa or a raw map\n", path);
+		file.Close();
+		return false;
+	}
+	return true;
+}
+
+bool MapImage::OpenTGA()
+{
+	if (file.Size() < 18)
+	{
+		return false;
+	}
+	TGAHEADER tgaHeader;
+	memcpy(&tgaHeader, file.Data(), 18/* sizeof(TGAHEADER)*/);
+	//only uncompressed true colour (2) or greyscale (3) images without a palette can be used in place
+	if (tgaHeader.colorMapType != 0 || (tgaHeader.imageType != 2 && tgaHeader.imageType != 3))
+	{
+		return false;
+	}
+	if (tgaHeader.bits != 8 && tgaHeader.bits != 24 && tgaHeader.bits != 32)
+	{
+		return false;
+	}
+	size_t offset = 18 + (unsigned char)tgaHeader.identsize;
+	size_t imageSize = (size_t)tgaHeader.width * tgaHeader.height * (tgaHeader.bits / 8);
+	if (file.Size() < offset + imageSize)
+	{
+		return false;
+	}
+	width = tgaHeader.width;
+	height = tgaHeader.height;
+	components = tgaHeader.bits / 8;
+	//targas store colour channels blue first
+	format = components == 4 ? GL_BGRA : (components == 3 ? GL_BGR : GL_RED);
+	pixels = file.Data() + offset;
+	return true;
+}
+
+bool MapImage::OpenRaw()
+{
+	RAWMAPHEADER rawHeader;
+	memcpy(&rawHeader, file.Data(), sizeof(RAWMAPHEADER));
+	if (rawHeader.components != 1 && rawHeader.components != 3 && rawHeader.components != 4)
+	{
+		return false;
+	}
+	size_t imageSize = (size_t)rawHeader.width * rawHeader.height * rawHeader.components;
+	if (file.Size() < sizeof(RAWMAPHEADER) + imageSize)
+	{
+		return false;
+	}
+	width = (int)rawHeader.width;
+	height = (int)rawHeader.height;
+	components = (int)rawHeader.components;
+	format = components == 4 ? GL_RGBA : (components == 3 ? GL_RGB : GL_RED);
+	pixels = file.Data() + sizeof(RAWMAPHEADER);
+	return true;
+}
+
+bool MapImage::IsLoaded()
+{
+	return pixels != nullptr;
+}
+
+const GLubyte* MapImage::GetPixels()
+{
+	return pixels;
+}
+
+int MapImage::GetWidth()
+{
+	return width;
+}
+
+int MapImage::GetHeight()
+{
+	return height;
+}
+
+int MapImage::GetComponents()
+{
+	return components;
+}
+
+GLenum MapImage::GetFormat()
+{
+	return format;
+}
+
+bool MapImage::WriteRaw(const char* path, const GLubyte* pixels, int width, int height, int components, GLenum format)
+{
+	FILE* pFile;
+#ifdef _MSC_VER
+	fopen_s(&pFile, path, "wb");
+#else
+	pFile = fopen(path, "wb");
+#endif
+	if (pFile == nullptr)
+	{
+		return false;
+	}
+	RAWMAPHEADER rawHeader;
+	memcpy(rawHeader.magic, RawMapMagic, 4);
+	rawHeader.width = (unsigned int)width;
+	rawHeader.height = (unsigned int)height;
+	rawHeader.components = (unsigned int)components;
+	bool written = fwrite(&rawHeader, sizeof(RAWMAPHEADER), 1, pFile) == 1;
+	bool swapRedBlue = format == GL_BGRA || format == GL_BGR;
+	//a row at a time, so swapping the channels doesn't need a copy of the whole image
+	std::vector<GLubyte> row(width * components);
+	for (int y = 0; y < height && written; y++)
+	{
+		const GLubyte* source = pixels + (size_t)y * width * components;
+		memcpy(&row[0], source, row.size());
+		if (swapRedBlue)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				std::swap(row[x * components], row[x * components + 2]);
+			}
+		}
+		written = fwrite(&row[0], row.size(), 1, pFile) == 1;
+	}
+	fclose(pFile);
+	return written;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+#include "MappedFile.h"
+#include "TGALoader.h"
+
+//Header of the raw map format, followed directly by width * height * components bytes. Rows run bottom to top like a
+//targa, but channels are stored in R, G, B(, A) order so the data needs no swizzling anywhere
+#pragma pack(1)
+typedef struct
+{
+	char magic[4];	// "SCAM"
+	unsigned int width;
+	unsigned int height;
+	unsigned int components;	// 1, 3 or 4 bytes per pixel
+} RAWMAPHEADER;
+#pragma pack(8)
+
+//Read only view of the pixels of an uncompressed targa or raw map file, used in place from a memory mapping
+//The format tells the channel order of the data (GL_BGRA, GL_BGR, GL_RGBA, GL_RGB or GL_RED) and can be handed to GL as is
+class MapImage
+{
+private:
+	MappedFile file;
+	const GLubyte* pixels;
+	int width, height, components;
+	GLenum format;
+	bool OpenTGA();
+	bool OpenRaw();
+public:
+	MapImage();
+	bool Open(const char* path);	//prints why and returns false if the file can't be used
+	bool IsLoaded();
+	const GLubyte* GetPixels();
+	int GetWidth();
+	int GetHeight();
+	int GetComponents();
+	GLenum GetFormat();
+	//writes pixels of the given format as a raw map, converting BGR(A) to RGB(A) on the way
+	static bool WriteRaw(const char* path, const GLubyte* pixels, int width, int height, int components, GLenum format);
+};
@@ -1,97 +1,253 @@
 #include "MapLayer.h"
 
-MapLayer::MapLayer(const char* path, int width, int height, int type)
+MapLayer::MapLayer(const char* path, int width, int height, int type, ThreadPool* pool)
 {
 	mapType = type;
 	mapWidth = width;
 	mapHeight = height;
-	//load the texture data
-	tex = new Texture();
-	int nWidth, nHeight, nComponents;
-	GLenum eFormat;
-	GLbyte* pixels = readTGABits(path, &nWidth, &nHeight, &nComponents, &eFormat);
-	vPixels = std::vector<GLubyte>(pixels, pixels + (nWidth * nHeight * 4));
-	tex->loadFromPixels(vPixels, nWidth, nHeight);
-	free(pixels);
-	//create the mesh	(might extract this out into a standalone mesh servicing multiple layers if I need to)
-	BuildMesh(width, height);
-
-
-	
-	/*float westAccessibility = AccessibilityBetweenPoints(glm::vec2(55.f, 690.f), glm::vec2(55.f, 697.f));	//test accessibility value for very flat land
-	printf("West ac is %f\n", westAccessibility);
-	float mountAccessibility = AccessibilityBetweenPoints(glm::vec2(676.f, 482.f), glm::vec2(697.f, 478.f));	//test accessibility value for steep slope
-	printf("Mount ac is %f\n", mountAccessibility);*/
-}
-
-void MapLayer::BuildMesh(int width, int height)
-{
-	float fW = (float)width;
-	float fH = (float)height;
-	TVertex v0 = TVertex(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 0.0f));
-	TVertex v1 = TVertex(glm::vec4(fW, 0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 0.0f));
-	TVertex v2 = TVertex(glm::vec4(fW, fH, 0.0f, 1.0f), glm::vec2(1.0f, 1.0f));
-	TVertex v3 = TVertex(glm::vec4(0.0f, fH, 0.0f, 1.0f), glm::vec2(0.0f, 1.0f));
-	vertices.push_back(v0);
-	vertices.push_back(v1);
-	vertices.push_back(v2);
-	vertices.push_back(v3);
-	indices.push_back(0);
-	indices.push_back(1);
-	indices.push_back(2);
-	indices.push_back(0);
-	indices.push_back(2);
-	indices.push_back(3);
-	indexCount = indices.size();
-	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(TVertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
-	//position
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TVertex), (const GLvoid*)0);
-	glEnableVertexAttribArray(0);
-	//color
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TVertex), (const GLvoid*)16);
-	glEnableVertexAttribArray(1);
-	glGenBuffers(1, &ibo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), &indices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
-
-void MapLayer::Draw()
-{
-	glActiveTexture(GL_TEXTURE0);
-	tex->use();
-	//the mesh
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	pixels = nullptr;
+	tileCache = nullptr;
+	tileSize = tilesX = tilesY = 0;
+	//map the image data, the pixels are read straight from the file mapping
+	image = new MapImage();
+	if (!image->Open(path))
+	{
+		printf("Could not load map layer %s\n", path);
+		pixelWidth = 0;
+		pixelHeight = 0;
+		return;
+	}
+	pixelWidth = image->GetWidth();
+	pixelHeight = image->GetHeight();
+	if (pixelWidth < mapWidth || pixelHeight < mapHeight)
+	{
+		printf("Map layer %s is %ix%i pixels, smaller than the %ix%i map\n", path, pixelWidth, pixelHeight, mapWidth, mapHeight);
+		return;
+	}
+	SetPixelLayout(image->GetPixels(), image->GetFormat(), image->GetComponents());
+	BuildLookupTables(pool);
 }
 
-bool MapLayer::Walkable(int x, int y)
+MapLayer::MapLayer(std::vector<GLubyte> rgbaPixels, int width, int height, int type, ThreadPool* pool)
 {
-	int pidx = x + 1024 * y;
-	return vPixels[4 * pidx + 3] > 0;
+	mapType = type;
+	mapWidth = width;
+	mapHeight = height;
+	pixelWidth = width;
+	pixelHeight = height;
+	image = nullptr;
+	tileCache = nullptr;
+	tileSize = tilesX = tilesY = 0;
+	ownedPixels = std::move(rgbaPixels);
+	SetPixelLayout(ownedPixels.empty() ? nullptr : ownedPixels.data(), GL_RGBA, 4);
+	BuildLookupTables(pool);
 }
 
-float MapLayer::MaxmimalSlope(int x, int y)
+void MapLayer::SetPixelLayout(const GLubyte* data, GLenum format, int components)
+{
+	pixels = data;
+	pixelFormat = format;
+	pixelStride = components;
+	if (components == 1)
+	{
+		redOffset = greenOffset = blueOffset = 0;
+		alphaOffset = -1;
+		return;
+	}
+	bool blueFirst = format == GL_BGRA || format == GL_BGR;
+	redOffset = blueFirst ? 2 : 0;
+	greenOffset = 1;
+	blueOffset = blueFirst ? 0 : 2;
+	alphaOffset = components == 4 ? 3 : -1;
+}
+
+void MapLayer::BuildLookupTables(ThreadPool* pool)
+{
+	if (pixels == nullptr)
+	{
+		return;
+	}
+	if ((long long)mapWidth * mapHeight > tiledLayerThreshold)
+	{
+		//too big to decode up front, build the tables a tile at a time as they are needed and keep only the recently used ones
+		tileSize = mapTileSize;
+		tilesX = (mapWidth + tileSize - 1) / tileSize;
+		tilesY = (mapHeight + tileSize - 1) / tileSize;
+		tileCache = new TileCache(mapTileCacheCapacity, [this](int key) { return BuildTile(key); });
+		return;
+	}
+	//decode every map pixel once, the tables cover the map area so lookups only need the same clamping as ColorLookup
+	if (mapType == MAPTYPE_ROADS)
+	{
+		roadClasses.resize(mapWidth * mapHeight);
+	}
+	else if (mapType == MAPTYPE_HEIGHT)
+	{
+		heights.resize(mapWidth * mapHeight);
+		slopes.resize(mapWidth * mapHeight);
+		gradients.resize(mapWidth * mapHeight);
+	}
+	int bandCount = (mapHeight + LookupBandRows - 1) / LookupBandRows;
+	pool->ParallelFor(bandCount, [&](int band)
+	{
+		int y0 = band * LookupBandRows;
+		size_t offset = (size_t)mapWidth * y0;
+		BuildBlock(0, y0, mapWidth, std::min(LookupBandRows, mapHeight - y0), mapWidth,
+			roadClasses.empty() ? nullptr : &roadClasses[offset], heights.empty() ? nullptr : &heights[offset],
+			slopes.empty() ? nullptr : &slopes[offset], gradients.empty() ? nullptr : &gradients[offset]);
+	});
+}
+
+std::shared_ptr<MapTile> MapLayer::BuildTile(int key)
+{
+	std::shared_ptr<MapTile> tile = std::make_shared<MapTile>();
+	tile->x0 = (key % tilesX) * tileSize;
+	tile->y0 = (key / tilesX) * tileSize;
+	tile->width = std::min(tileSize, mapWidth - tile->x0);
+	tile->height = std::min(tileSize, mapHeight - tile->y0);
+	int area = tile->width * tile->height;
+	if (mapType == MAPTYPE_ROADS)
+	{
+		tile->roadClasses.resize(area);
+	}
+	else if (mapType == MAPTYPE_HEIGHT)
+	{
+		tile->heights.resize(area);
+		tile->slopes.resize(area);
+		tile->gradients.resize(area);
+	}
+	BuildBlock(tile->x0, tile->y0, tile->width, tile->height, tile->width,
+		tile->roadClasses.empty() ? nullptr : &tile->roadClasses[0], tile->heights.empty() ? nullptr : &tile->heights[0],
+		tile->slopes.empty() ? nullptr : &tile->slopes[0], tile->gradients.empty() ? nullptr : &tile->gradients[0]);
+	return tile;
+}
+
+void MapLayer::BuildBlock(int x0, int y0, int w, int h, int stride, unsigned char* classesOut, float* heightsOut, float* slopesOut, glm::vec2* gradientsOut)
+{
+	if (mapType == MAPTYPE_ROADS)
+	{
+		for (int y = 0; y < h; y++)
+		{
+			for (int x = 0; x < w; x++)
+			{
+				const GLubyte* pixel = PixelAt(x0 + x, y0 + y);
+				classesOut[x + stride * y] = RoadClassFromColor(pixel[redOffset], pixel[greenOffset], pixel[blueOffset]);
+			}
+		}
+	}
+	else if (mapType == MAPTYPE_HEIGHT)
+	{
+		//heights and alphas with a 1 pixel border, clamped at the map edges, so the slopes and gradients can be worked out
+		//without reaching into other blocks
+		int bw = w + 2;
+		std::vector<float> border(bw * (h + 2));
+		std::vector<float> alphaBorder(bw * (h + 2));
+		for (int by = 0; by < h + 2; by++)
+		{
+			int gy = std::min(std::max(y0 + by - 1, 0), mapHeight - 1);
+			for (int bx = 0; bx < bw; bx++)
+			{
+				int gx = std::min(std::max(x0 + bx - 1, 0), mapWidth - 1);
+				const GLubyte* pixel = PixelAt(gx, gy);
+				border[bx + bw * by] = ((float)(pixel[redOffset] + pixel[greenOffset] + pixel[blueOffset])) / HeightScalingFactor;
+				alphaBorder[bx + bw * by] = alphaOffset < 0 ? 255.0f : (float)pixel[alphaOffset];
+			}
+		}
+		for (int y = 0; y < h; y++)
+		{
+			int gy = y0 + y;
+			//central differences span 2 pixels, or 1 where the edge clamps a neighbour
+			float dy = (float)std::max(std::min(gy + 1, mapHeight - 1) - std::max(gy - 1, 0), 1);
+			for (int x = 0; x < w; x++)
+			{
+				int gx = x0 + x;
+				float dx = (float)std::max(std::min(gx + 1, mapWidth - 1) - std::max(gx - 1, 0), 1);
+				int b = (x + 1) + bw * (y + 1);
+				float hCentre = border[b];
+				float hLeft = border[b - 1];
+				float hRight = border[b + 1];
+				float hDown = border[b - bw];
+				float hUp = border[b + bw];
+				//the slope is measured on the alpha channel, as it always has been, while heights come from the colour
+				float aCentre = alphaBorder[b];
+				float m = fabsf(aCentre - alphaBorder[b - 1]);
+				m = std::max(m, fabsf(aCentre - alphaBorder[b + 1]));
+				m = std::max(m, fabsf(aCentre - alphaBorder[b + bw]));
+				m = std::max(m, fabsf(aCentre - alphaBorder[b - bw]));
+				heightsOut[x + stride * y] = hCentre;
+				slopesOut[x + stride * y] = m;
+				gradientsOut[x + stride * y] = glm::vec2((hRight - hLeft) / dx, (hUp - hDown) / dy);
+			}
+		}
+	}
+}
+
+const GLubyte* MapLayer::PixelAt(int x, int y)
+{
+	return pixels + (size_t)pixelStride * ((size_t)x + (size_t)pixelWidth * y);
+}
+
+std::shared_ptr<const MapTile> MapLayer::TileAt(int x, int y)
+{
+	return tileCache->Get(x / tileSize + tilesX * (y / tileSize));
+}
+
+bool MapLayer::IsLoaded()
 {
-	//detemine index of relevant pixels
-	int pidx = x + mapWidth * y;
-	int left = x > 0 ? pidx - 1 : pidx;
-	int right = x < mapWidth - 1 ? pidx + 1 : pidx;
-	int bot = y > 0 ? pidx - mapWidth : pidx;
-	int top = y < mapHeight - 1 ? y + mapWidth : y;
+	return pixels != nullptr;
+}
 
-	float m = (float)abs(vPixels[4 * pidx + 3] - vPixels[4 * left + 3]);
-	m = std::max(m, (float)abs(vPixels[4 * pidx + 3] - vPixels[4 * right + 3]));
-	m = std::max(m, (float)abs(vPixels[4 * pidx + 3] - vPixels[4 * top + 3]));
-	m = std::max(m, (float)abs(vPixels[4 * pidx + 3] - vPixels[4 * bot + 3]));
+int MapLayer::GetWidth()
+{
+	return mapWidth;
+}
 
-	return m;
+int MapLayer::GetHeight()
+{
+	return mapHeight;
+}
+
+int MapLayer::GetPixelWidth()
+{
+	return pixelWidth;
+}
+
+int MapLayer::GetPixelHeight()
+{
+	return pixelHeight;
+}
+
+const GLubyte* MapLayer::GetPixels()
+{
+	return pixels;
+}
+
+GLenum MapLayer::GetPixelFormat()
+{
+	return pixelFormat;
+}
+
+bool MapLayer::Walkable(int x, int y)
+{
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x >= mapWidth) x = mapWidth - 1;
+	if (y >= mapHeight) y = mapHeight - 1;
+	return alphaOffset < 0 || PixelAt(x, y)[alphaOffset] > 0;
+}
+
+float MapLayer::MaxmimalSlope(int x, int y)
+{
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x >= mapWidth) x = mapWidth - 1;
+	if (y >= mapHeight) y = mapHeight - 1;
+	if (tileCache == nullptr)
+	{
+		return slopes[x + mapWidth * y];
+	}
+	std::shared_ptr<const MapTile> tile = TileAt(x, y);
+	return tile->slopes[(x - tile->x0) + tile->width * (y - tile->y0)];
 }
 
 float MapLayer::HeightLookup(int x, int y)
@@ -100,11 +256,69 @@ float MapLayer::HeightLookup(int x, int y)
 	if (y < 0) y = 0;
 	if (x >= mapWidth) x = mapWidth - 1;
 	if (y >= mapHeight) y = mapHeight - 1;
-	int pidx = x + mapWidth * y;
-	int r = vPixels[4 * pidx];
-	int g = vPixels[4 * pidx + 1];
-	int b = vPixels[4 * pidx + 2];
-	return ((float)(r + g + b)) / HeightScalingFactor;
+	if (tileCache == nullptr)
+	{
+		return heights[x + mapWidth * y];
+	}
+	std::shared_ptr<const MapTile> tile = TileAt(x, y);
+	return tile->heights[(x - tile->x0) + tile->width * (y - tile->y0)];
+}
+
+glm::vec2 MapLayer::GradientLookup(int x, int y)
+{
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x >= mapWidth) x = mapWidth - 1;
+	if (y >= mapHeight) y = mapHeight - 1;
+	if (tileCache == nullptr)
+	{
+		return gradients[x + mapWidth * y];
+	}
+	std::shared_ptr<const MapTile> tile = TileAt(x, y);
+	return tile->gradients[(x - tile->x0) + tile->width * (y - tile->y0)];
+}
+
+void MapLayer::BilinearCorners(glm::vec2 p, int* x0, int* y0, int* x1, int* y1, float* tx, float* ty)
+{
+	//pixel centres sit at +0.5, and samples beyond the outer centres clamp to the edge
+	float fx = std::min(std::max(p.x - 0.5f, 0.0f), (float)(mapWidth - 1));
+	float fy = std::min(std::max(p.y - 0.5f, 0.0f), (float)(mapHeight - 1));
+	*x0 = (int)fx;
+	*y0 = (int)fy;
+	*x1 = std::min(*x0 + 1, mapWidth - 1);
+	*y1 = std::min(*y0 + 1, mapHeight - 1);
+	*tx = fx - (float)*x0;
+	*ty = fy - (float)*y0;
+}
+
+float MapLayer::HeightAt(glm::vec2 p)
+{
+	int x0, y0, x1, y1;
+	float tx, ty;
+	BilinearCorners(p, &x0, &y0, &x1, &y1, &tx, &ty);
+	float bottom = HeightLookup(x0, y0) + (HeightLookup(x1, y0) - HeightLookup(x0, y0)) * tx;
+	float top = HeightLookup(x0, y1) + (HeightLookup(x1, y1) - HeightLookup(x0, y1)) * tx;
+	return bottom + (top - bottom) * ty;
+}
+
+float MapLayer::SlopeAt(glm::vec2 p)
+{
+	int x0, y0, x1, y1;
+	float tx, ty;
+	BilinearCorners(p, &x0, &y0, &x1, &y1, &tx, &ty);
+	float bottom = MaxmimalSlope(x0, y0) + (MaxmimalSlope(x1, y0) - MaxmimalSlope(x0, y0)) * tx;
+	float top = MaxmimalSlope(x0, y1) + (MaxmimalSlope(x1, y1) - MaxmimalSlope(x0, y1)) * tx;
+	return bottom + (top - bottom) * ty;
+}
+
+glm::vec2 MapLayer::GradientAt(glm::vec2 p)
+{
+	int x0, y0, x1, y1;
+	float tx, ty;
+	BilinearCorners(p, &x0, &y0, &x1, &y1, &tx, &ty);
+	glm::vec2 bottom = GradientLookup(x0, y0) + (GradientLookup(x1, y0) - GradientLookup(x0, y0)) * tx;
+	glm::vec2 top = GradientLookup(x0, y1) + (GradientLookup(x1, y1) - GradientLookup(x0, y1)) * tx;
+	return bottom + (top - bottom) * ty;
 }
 
 glm::vec4 MapLayer::ColorLookup(int x, int y)
@@ -113,46 +327,70 @@ glm::vec4 MapLayer::ColorLookup(int x, int y)
 	if (y < 0) y = 0;
 	if (x >= mapWidth) x = mapWidth - 1;
 	if (y >= mapHeight) y = mapHeight - 1;
-	int pidx = x + mapWidth * y;
-	int r = vPixels[4 * pidx];
-	int g = vPixels[4 * pidx + 1];
-	int b = vPixels[4 * pidx + 2];
-	int a = vPixels[4 * pidx + 3];
+	const GLubyte* pixel = PixelAt(x, y);
+	int r = pixel[redOffset];
+	int g = pixel[greenOffset];
+	int b = pixel[blueOffset];
+	int a = alphaOffset < 0 ? 255 : pixel[alphaOffset];
 	return glm::vec4(r, g, b, a);
 }
 
 float MapLayer::RoadScaleFactorFromColor(glm::vec4 color)
 {
-	if (color.r > 220 && color.g > 220 && color.b > 220)
+	return RoadClassScale[RoadClassFromColor((int)color.r, (int)color.g, (int)color.b)];
+}
+
+unsigned char MapLayer::RoadClassFromColor(int r, int g, int b)
+{
+	if (r > 220 && g > 220 && b > 220)
 	{
-		return ROAD_NONE;
+		return ROADCLASS_NONE;
 	}
-	else if (color.r < 100 && color.g > 220 && color.b > 220)
+	else if (r < 100 && g > 220 && b > 220)
 	{
-		return ROAD_MOTORWAY;
+		return ROADCLASS_MOTORWAY;
 	}
-	else if (color.g > 100 && color.g > color.r && color.g > color.b)
+	else if (g > 100 && g > r && g > b)
 	{
-		return ROAD_MAJOR;
+		return ROADCLASS_MAJOR;
 	}
-	else if (color.r > 200 && color.g < 100 && color.b < 100)
+	else if (r > 200 && g < 100 && b < 100)
 	{
-		return ROAD_MINOR;
+		return ROADCLASS_MINOR;
 	}
-	else if (color.b > 200 && color.b > color.g && color.b > color.r)
+	else if (b > 200 && b > g && b > r)
 	{
-		return ROAD_DRIVEWAY;
+		return ROADCLASS_DRIVEWAY;
 	}
-	else if (color.r > 190 && color.b > 140 && color.g > 160 && color.r < 210 && color.b < 160 && color.g < 190)
+	else if (r > 190 && b > 140 && g > 160 && r < 210 && b < 160 && g < 190)
 	{
-		return IMPASSIBLE;
+		return ROADCLASS_IMPASSIBLE;
 	}
 	else
 	{
-		return ROAD_NONE;
+		return ROADCLASS_NONE;
 	}
 }
 
+unsigned char MapLayer::RoadClassLookup(int x, int y)
+{
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x >= mapWidth) x = mapWidth - 1;
+	if (y >= mapHeight) y = mapHeight - 1;
+	if (tileCache == nullptr)
+	{
+		return roadClasses[x + mapWidth * y];
+	}
+	std::shared_ptr<const MapTile> tile = TileAt(x, y);
+	return tile->roadClasses[(x - tile->x0) + tile->width * (y - tile->y0)];
+}
+
+float MapLayer::RoadScaleLookup(int x, int y)
+{
+	return RoadClassScale[RoadClassLookup(x, y)];
+}
+
 float MapLayer::AccessibilityBetweenPoints(glm::vec2 p1, glm::vec2 p2)
 {
 	//heightmap based accessibility
@@ -163,12 +401,125 @@ float MapLayer::AccessibilityBetweenPoints(glm::vec2 p1, glm::vec2 p2)
 
 
 	//roadway based accessibility
-	float startRoad = RoadScaleFactorFromColor(ColorLookup((int)p1.x, (int)p1.y));
-	float endRoad = RoadScaleFactorFromColor(ColorLookup((int)p2.x, (int)p2.y));
+	float startRoad = RoadScaleLookup((int)p1.x, (int)p1.y);
+	float endRoad = RoadScaleLookup((int)p2.x, (int)p2.y);
 	return startRoad + endRoad;
 }
 
+float MapLayer::AccessibilityAlongLine(glm::vec2 p1, glm::vec2 p2, MapLayer* heightMap, float slopeFactor)
+{
+	//walk every pixel the line passes through (Amanatides & Woo), so a segment can't step over an impassable band
+	int x = (int)floorf(p1.x);
+	int y = (int)floorf(p1.y);
+	int endX = (int)floorf(p2.x);
+	int endY = (int)floorf(p2.y);
+	glm::vec2 d = p2 - p1;
+	int stepX = d.x > 0.0f ? 1 : -1;
+	int stepY = d.y > 0.0f ? 1 : -1;
+	const float infinity = std::numeric_limits<float>::infinity();
+	float tDeltaX = d.x != 0.0f ? fabsf(1.0f / d.x) : infinity;
+	float tDeltaY = d.y != 0.0f ? fabsf(1.0f / d.y) : infinity;
+	float tMaxX = d.x > 0.0f ? ((float)(x + 1) - p1.x) * tDeltaX : (d.x < 0.0f ? (p1.x - (float)x) * tDeltaX : infinity);
+	float tMaxY = d.y > 0.0f ? ((float)(y + 1) - p1.y) * tDeltaY : (d.y < 0.0f ? (p1.y - (float)y) * tDeltaY : infinity);
+	int steps = abs(endX - x) + abs(endY - y);
+	bool useSlope = heightMap != nullptr && slopeFactor > 0.0f;
+
+	//when both layers cover the same grid, clamp once and index both layers' tables (or tiles) directly
+	bool sameGrid = useSlope && heightMap->mapWidth == mapWidth && heightMap->mapHeight == mapHeight;
+	float run = glm::length(d);
+	glm::vec2 direction = run > 0.0f ? d / run : glm::vec2(0.0f, 0.0f);
+
+	std::shared_ptr<const MapTile> roadTile;
+	std::shared_ptr<const MapTile> heightTile;
+	float scaleSum = 0.0f;
+	float slopeSum = 0.0f;
+	for (int i = 0; i <= steps; i++)
+	{
+		int cx = std::min(std::max(x, 0), mapWidth - 1);
+		int cy = std::min(std::max(y, 0), mapHeight - 1);
+		int pidx = cx + mapWidth * cy;
+		unsigned char roadClass;
+		if (tileCache == nullptr)
+		{
+			roadClass = roadClasses[pidx];
+		}
+		else
+		{
+			//keep hold of the current tile, a line only crosses into another one every tileSize pixels at most
+			if (roadTile == nullptr || cx < roadTile->x0 || cy < roadTile->y0 || cx >= roadTile->x0 + roadTile->width || cy >= roadTile->y0 + roadTile->height)
+			{
+				roadTile = TileAt(cx, cy);
+			}
+			roadClass = roadTile->roadClasses[(cx - roadTile->x0) + roadTile->width * (cy - roadTile->y0)];
+		}
+		if (roadClass == ROADCLASS_IMPASSIBLE)
+		{
+			return 0.0f;
+		}
+		scaleSum += RoadClassScale[roadClass];
+		if (useSlope)
+		{
+			//rate of climb in the direction of travel across this pixel
+			glm::vec2 g;
+			if (!sameGrid)
+			{
+				g = heightMap->GradientAt(glm::vec2((float)x + 0.5f, (float)y + 0.5f));
+			}
+			else if (heightMap->tileCache == nullptr)
+			{
+				g = heightMap->gradients[pidx];
+			}
+			else
+			{
+				if (heightTile == nullptr || cx < heightTile->x0 || cy < heightTile->y0 || cx >= heightTile->x0 + heightTile->width || cy >= heightTile->y0 + heightTile->height)
+				{
+					heightTile = heightMap->TileAt(cx, cy);
+				}
+				g = heightTile->gradients[(cx - heightTile->x0) + heightTile->width * (cy - heightTile->y0)];
+			}
+			slopeSum += fabsf(g.x * direction.x + g.y * direction.y);
+		}
+		if (tMaxX < tMaxY)
+		{
+			tMaxX += tDeltaX;
+			x += stepX;
+		}
+		else
+		{
+			tMaxY += tDeltaY;
+			y += stepY;
+		}
+	}
+
+	//scaled to the same range as the old start + end sum, so segment lengths are comparable
+	float accessibility = 2.0f * scaleSum / (float)(steps + 1);
+	if (useSlope)
+	{
+		accessibility *= std::max(0.0f, 1.0f - slopeFactor * slopeSum / (float)(steps + 1));
+	}
+	return accessibility;
+}
+
+void MapLayer::AccessibilityAlongLines(const glm::vec2* starts, const glm::vec2* ends, float* accessibility, int count, MapLayer* heightMap, float slopeFactor)
+{
+	for (int i = 0; i < count; i++)
+	{
+		accessibility[i] = AccessibilityAlongLine(starts[i], ends[i], heightMap, slopeFactor);
+	}
+}
+
 MapLayer::~MapLayer()
 {
-	delete tex;
+	delete tileCache;
+	delete image;
+}
+
+bool MapLayer::IsTiled()
+{
+	return tileCache != nullptr;
+}
+
+int MapLayer::GetTileSize()
+{
+	return tileSize;
 }
\ No newline at end of file
@@ -1,14 +1,20 @@
 #pragma once
 
-#include "glad\glad.h"
-#include "glm\glm.hpp"
+#include "glad/glad.h"
+#include "glm/glm.hpp"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <stdio.h>
 #include <vector>
-#include "Texture.h"
-#include "Vertex.h"
+#include "MapImage.h"
+#include "ThreadPool.h"
+#include "TileCache.h"
 
 const static float HeightScalingFactor = 5.50f;
+static long long tiledLayerThreshold = 8192LL * 8192;	//layers covering more map pixels than this build their lookup tables in tiles on demand rather than up front
+static int mapTileSize = 256;	//width and height of a tile in pixels
+static int mapTileCacheCapacity = 256;	//tiles a tiled layer keeps, which bounds its table memory (about 1MB a tile for height layers, 64KB for road layers)
 
 const static float ROAD_MOTORWAY = 0.5f;
 const static float ROAD_MAJOR = 0.4f;
@@ -17,31 +23,80 @@ const static float ROAD_DRIVEWAY = 0.2f;
 const static float ROAD_NONE = 0.1f;
 const static float IMPASSIBLE = 0.0f;
 
+//road classes as stored in a road layer's class raster, indexing RoadClassScale
+const static unsigned char ROADCLASS_MOTORWAY = 0;
+const static unsigned char ROADCLASS_MAJOR = 1;
+const static unsigned char ROADCLASS_MINOR = 2;
+const static unsigned char ROADCLASS_DRIVEWAY = 3;
+const static unsigned char ROADCLASS_NONE = 4;
+const static unsigned char ROADCLASS_IMPASSIBLE = 5;
+const static int ROADCLASS_COUNT = 6;
+const static float RoadClassScale[ROADCLASS_COUNT] = { ROAD_MOTORWAY, ROAD_MAJOR, ROAD_MINOR, ROAD_DRIVEWAY, ROAD_NONE, IMPASSIBLE };
+
 
 const static int MAPTYPE_HEIGHT = 0;
 const static int MAPTYPE_ROADS = 1;
 
+//CPU side copy of a map image used during generation. Drawing it is left to MapRenderer so the layer can be loaded without a GL context
 class MapLayer
 {
 private:
-	Texture* tex;
-	GLuint vbo, vao, ibo;
-	int indexCount;
-	std::vector<TVertex> vertices;
-	std::vector<int> indices;
-	void BuildMesh(int width, int height);
-	std::vector<GLubyte> vPixels;
+	MapImage* image;	//file backed layers, keeps the mapping that pixels points into alive
+	std::vector<GLubyte> ownedPixels;	//layers built from memory
+	const GLubyte* pixels;	//read only, pixelStride bytes per pixel with the channels at the offsets below
+	GLenum pixelFormat;
+	int pixelStride;
+	int redOffset, greenOffset, blueOffset, alphaOffset;	//alphaOffset is -1 when there is no alpha channel
+	std::vector<unsigned char> roadClasses;	//road layers only, one class per pixel so generation reads 1 byte instead of classifying 4
+	std::vector<float> heights;	//height layers only, decoded from the colour channels
+	std::vector<float> slopes;	//height layers only, largest alpha difference to a 4-neighbour
+	std::vector<glm::vec2> gradients;	//height layers only, central difference height gradient
 	int mapWidth, mapHeight;
+	int pixelWidth, pixelHeight;
 	int mapType;
+	TileCache* tileCache;	//tiled layers only, which leave the whole map tables above empty
+	int tileSize, tilesX, tilesY;
+	static constexpr int LookupBandRows = 64;	//rows per parallel work item when building the lookup tables
+	void SetPixelLayout(const GLubyte* data, GLenum format, int components);
+	void BuildLookupTables(ThreadPool* pool);
+	std::shared_ptr<MapTile> BuildTile(int key);
+	//fills the tables for map pixels [x0, x0 + w) x [y0, y0 + h), rows stride apart - only the tables for the layer's type are written
+	void BuildBlock(int x0, int y0, int w, int h, int stride, unsigned char* classesOut, float* heightsOut, float* slopesOut, glm::vec2* gradientsOut);
+	const GLubyte* PixelAt(int x, int y);	//unclamped
+	void BilinearCorners(glm::vec2 p, int* x0, int* y0, int* x1, int* y1, float* tx, float* ty);
 	
 public:
-	MapLayer(const char* path, int width, int height, int type);
+	//the lookup tables of untiled layers are built on pool, which is only used during construction
+	MapLayer(const char* path, int width, int height, int type, ThreadPool* pool);	//uncompressed targa or raw map, memory mapped rather than read
+	MapLayer(std::vector<GLubyte> rgbaPixels, int width, int height, int type, ThreadPool* pool);	//from 4 byte per pixel data already in memory, one pixel per map unit
 	~MapLayer();
-	void Draw();
+	MapLayer(const MapLayer&) = delete;
+	MapLayer& operator=(const MapLayer&) = delete;
+	bool IsLoaded();
+	int GetWidth();
+	int GetHeight();
+	int GetPixelWidth();
+	int GetPixelHeight();
+	const GLubyte* GetPixels();	//GetPixelWidth() * GetPixelHeight() pixels in GetPixelFormat() order, valid for the layer's lifetime
+	GLenum GetPixelFormat();
+	bool IsTiled();
+	int GetTileSize();	//tiled layers only
+	std::shared_ptr<const MapTile> TileAt(int x, int y);	//tiled layers only, the tile covering (x, y) which must be on the map
 	bool Walkable(int x, int y);
-	float MaxmimalSlope(int x, int y);
-	float HeightLookup(int x, int y);
+	float MaxmimalSlope(int x, int y);	//height layers only, from the precomputed slope field of alpha differences
+	float HeightLookup(int x, int y);	//height layers only
+	glm::vec2 GradientLookup(int x, int y);	//height layers only
+	float HeightAt(glm::vec2 p);	//height layers only, bilinearly interpolated between pixel centres
+	float SlopeAt(glm::vec2 p);
+	glm::vec2 GradientAt(glm::vec2 p);
 	float AccessibilityBetweenPoints(glm::vec2 p1, glm::vec2 p2);	//Returns accessibility value [0...1] ranging from non-accessible to easily accessible
+	//Road layers only. Averages the road class over every pixel the line crosses (0 if any is impassable) on the same
+	//scale as AccessibilityBetweenPoints, then reduces it by the mean climb rate along the line from the height map's gradient field
+	float AccessibilityAlongLine(glm::vec2 p1, glm::vec2 p2, MapLayer* heightMap, float slopeFactor);
+	void AccessibilityAlongLines(const glm::vec2* starts, const glm::vec2* ends, float* accessibility, int count, MapLayer* heightMap, float slopeFactor);
 	glm::vec4 ColorLookup(int x, int y);
 	float RoadScaleFactorFromColor(glm::vec4 color);
+	static unsigned char RoadClassFromColor(int r, int g, int b);
+	unsigned char RoadClassLookup(int x, int y);	//road layers only, clamped to the map like ColorLookup
+	float RoadScaleLookup(int x, int y);	//same as RoadScaleFactorFromColor(ColorLookup(x, y)) from the class raster
 };
\ No newline at end of file
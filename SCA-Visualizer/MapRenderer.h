@@ -0,0 +1,25 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include "MapLayer.h"
+#include "Texture.h"
+#include "Vertex.h"
+
+//Draws a MapLayer as a textured quad spanning the map area
+class MapRenderer
+{
+private:
+	Texture* tex;
+	GLuint vbo, vao, ibo;
+	int indexCount;
+	std::vector<TVertex> vertices;
+	std::vector<int> indices;
+	void BuildMesh(int width, int height);
+
+public:
+	MapRenderer(MapLayer* layer);
+	~MapRenderer();
+	void Draw();
+};
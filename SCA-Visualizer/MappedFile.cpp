@@ -0,0 +1,122 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	//the mapping keeps its own reference to the file
+	close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		return false;
+	}
+	data = (const unsigned char*)mapped;
+	size = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+	}
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	if (data != nullptr)
+	{
+		munmap((void*)data, size);
+	}
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+bool MappedFile::IsOpen()
+{
+	return data != nullptr;
+}
+
+const unsigned char* MappedFile::Data()
+{
+	return data;
+}
+
+size_t MappedFile::Size()
+{
+	return size;
+}
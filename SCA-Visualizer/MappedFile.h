@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+//Read only memory mapping of a whole file. The contents are paged in by the OS on first touch, so a large map can be
+//used in place instead of being read into a buffer. The mapping lives until Close() or destruction
+class MappedFile
+{
+private:
+	const unsigned char* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen();
+	const unsigned char* Data();
+	size_t Size();
+};
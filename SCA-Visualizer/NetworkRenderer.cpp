@@ -0,0 +1,289 @@
+#include "NetworkRenderer.h"
+
+NetworkRenderer::NetworkRenderer(bool instanced, ThreadPool* pool)
+{
+	instancedMarkers = instanced;
+	fillPool = pool;
+	streaming = persistent = false;
+	bufferStorage = nullptr;
+	streamPointer = nullptr;
+	vertexCapacity = 0;
+	streamedSegments = 0;
+	vbo = vao = 0;
+	avbo = avao = aibo = 0;
+	vertexCount = 0;
+	APindexCount = 0;
+	APindexType = GL_UNSIGNED_INT;
+	markerCount = 0;
+}
+
+NetworkRenderer::~NetworkRenderer()
+{
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &avbo);
+	glDeleteBuffers(1, &aibo);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteVertexArrays(1, &avao);
+}
+
+void NetworkRenderer::ConstructAPMesh(const std::vector<glm::vec2>& attractionPoints, const std::vector<glm::vec2>& sites)
+{
+	if (attractionPoints.size() > 0 && instancedMarkers)
+	{
+		//16 bytes a marker rather than 4 vertices and 6 indices
+		std::vector<MarkerInstance> instances;
+		instances.reserve(attractionPoints.size() + sites.size());
+		for (unsigned int p = 0; p < attractionPoints.size(); p++)
+		{
+			instances.push_back(MarkerInstance(attractionPoints[p] + glm::vec2(0.5f), apCol, 1.0f));	//1 unit squares from the point up, as the quads were
+		}
+		for (unsigned int s = 0; s < sites.size(); s++)
+		{
+			instances.push_back(MarkerInstance(sites[s], siteCol, 4.0f));
+		}
+		markerCount = instances.size();
+		glGenVertexArrays(1, &avao);
+		glGenBuffers(1, &avbo);
+		glBindVertexArray(avao);
+		glBindBuffer(GL_ARRAY_BUFFER, avbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(MarkerInstance) * instances.size(), instances.data(), GL_STATIC_DRAW);
+		//position
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(MarkerInstance), (const GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribDivisor(0, 1);
+		//color
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(MarkerInstance), (const GLvoid*)8);
+		glEnableVertexAttribArray(1);
+		glVertexAttribDivisor(1, 1);
+		//size
+		glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(MarkerInstance), (const GLvoid*)12);
+		glEnableVertexAttribArray(2);
+		glVertexAttribDivisor(2, 1);
+	}
+	else if (attractionPoints.size() > 0)
+	{
+		int i = 0;
+		for (unsigned int p = 0; p < attractionPoints.size(); p++)
+		{
+			glm::vec2 currentPoint = attractionPoints[p];
+			Vertex v0 = Vertex(glm::vec2(currentPoint.x, currentPoint.y), apCol);
+			Vertex v1 = Vertex(glm::vec2(currentPoint.x + 1.0f, currentPoint.y), apCol);
+			Vertex v2 = Vertex(glm::vec2(currentPoint.x + 1.0f, currentPoint.y + 1.0f), apCol);
+			Vertex v3 = Vertex(glm::vec2(currentPoint.x, currentPoint.y + 1.0f), apCol);
+			APVertices.push_back(v0);
+			APVertices.push_back(v1);
+			APVertices.push_back(v2);
+			APVertices.push_back(v3);
+			APIndices.push_back(i * 4);
+			APIndices.push_back(i * 4 + 1);
+			APIndices.push_back(i * 4 + 2);
+			APIndices.push_back(i * 4);
+			APIndices.push_back(i * 4 + 2);
+			APIndices.push_back(i * 4 + 3);
+			i++;
+		}
+		if (sites.size() > 0)
+		{
+			for (unsigned int s = 0; s < sites.size(); s++)
+			{
+				glm::vec2 currentPoint = sites[s];
+				Vertex v0 = Vertex(glm::vec2(currentPoint.x - 2.0f, currentPoint.y - 2.0f), siteCol);
+				Vertex v1 = Vertex(glm::vec2(currentPoint.x + 2.0f, currentPoint.y - 2.0f), siteCol);
+				Vertex v2 = Vertex(glm::vec2(currentPoint.x + 2.0f, currentPoint.y + 2.0f), siteCol);
+				Vertex v3 = Vertex(glm::vec2(currentPoint.x - 2.0f, currentPoint.y + 2.0f), siteCol);
+				APVertices.push_back(v0);
+				APVertices.push_back(v1);
+				APVertices.push_back(v2);
+				APVertices.push_back(v3);
+				APIndices.push_back(i * 4);
+				APIndices.push_back(i * 4 + 1);
+				APIndices.push_back(i * 4 + 2);
+				APIndices.push_back(i * 4);
+				APIndices.push_back(i * 4 + 2);
+				APIndices.push_back(i * 4 + 3);
+				i++;
+			}
+		}
+		APindexCount = APIndices.size();
+		glGenVertexArrays(1, &avao);
+		glGenBuffers(1, &avbo);
+		glBindVertexArray(avao);
+		glBindBuffer(GL_ARRAY_BUFFER, avbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * APVertices.size(), &APVertices[0], GL_STATIC_DRAW);
+		//position
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		//color
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)8);
+		glEnableVertexAttribArray(1);
+		glGenBuffers(1, &aibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, aibo);
+		APindexType = UploadIndices(APIndices, APVertices.size());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
+void NetworkRenderer::FillLineVertices(SegmentPool& segments, int first, int last, Vertex* out)
+{
+	for (int i = first; i < last; i++)
+	{
+		const Segment& s = segments[i];
+		out[2 * (i - first)] = Vertex(s.start, s.col);
+		out[2 * (i - first) + 1] = Vertex(s.end, s.col);
+	}
+}
+
+void NetworkRenderer::ConstructMesh(RoadNetwork* network)
+{
+	SegmentPool& segments = *network->GetSegments();
+	int segmentCount = segments.Size();
+	if (segmentCount > 0)
+	{
+		vertexCount = 2 * segmentCount;
+		GLsizeiptr bufferSize = sizeof(Vertex) * (GLsizeiptr)vertexCount;
+		glGenVertexArrays(1, &vao);
+		glGenBuffers(1, &vbo);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
+		//the vertices are written by the fill threads straight into the driver's memory, one chunk per pool block
+		int chunkSize = 1 << SegmentPool::BlockShift;
+		int chunkCount = (segmentCount + chunkSize - 1) / chunkSize;
+		Vertex* mapped = (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		bool uploaded = false;
+		if (mapped != nullptr)
+		{
+			fillPool->ParallelFor(chunkCount, [&](int c) { FillLineVertices(segments, c * chunkSize, std::min(segmentCount, (c + 1) * chunkSize), mapped + 2 * c * chunkSize); });
+			uploaded = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;	//false if the store was lost while mapped, e.g. on a mode switch
+		}
+		if (!uploaded)
+		{
+			printf("Could not map the network's vertex buffer, uploading through a copy instead\n");
+			std::vector<Vertex> staging(vertexCount, Vertex(glm::vec2(0.0f), glm::vec4(0.0f)));
+			fillPool->ParallelFor(chunkCount, [&](int c) { FillLineVertices(segments, c * chunkSize, std::min(segmentCount, (c + 1) * chunkSize), staging.data() + 2 * c * chunkSize); });
+			glBufferData(GL_ARRAY_BUFFER, bufferSize, staging.data(), GL_STATIC_DRAW);
+		}
+		//position
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		//color
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)8);
+		glEnableVertexAttribArray(1);
+	}
+}
+
+void NetworkRenderer::EnableStreaming(GLADloadproc load)
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major > 4 || (major == 4 && minor >= 4))
+	{
+		bufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+	}
+	persistent = bufferStorage != nullptr;
+	if (!persistent)
+	{
+		printf("Persistent buffer mapping needs GL 4.4, streaming the network through glBufferSubData instead\n");
+	}
+	streaming = true;
+	glGenVertexArrays(1, &vao);
+}
+
+void NetworkRenderer::ReserveStream(int vertices, bool reallocate)
+{
+	if (vertices <= vertexCapacity && !reallocate)
+	{
+		return;
+	}
+	//doubling keeps the copies below down to a constant amount of work per streamed segment
+	int capacity = vertices <= vertexCapacity ? vertexCapacity : std::max(vertices, std::max(2 * vertexCapacity, 65536));
+	GLsizeiptr bufferSize = sizeof(Vertex) * (GLsizeiptr)capacity;
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (persistent)
+	{
+		//dynamic storage as well so the glBufferSubData path still works if the mapping fails
+		bufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_DYNAMIC_STORAGE_BIT);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_DYNAMIC_DRAW);
+	}
+	if (vbo != 0)
+	{
+		//keep what has been streamed so far, copied on the GPU. GL holds on to the old buffer until the frames drawing from it are done
+		glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, sizeof(Vertex) * 2 * (GLsizeiptr)streamedSegments);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &vbo);
+	}
+	vbo = buffer;
+	vertexCapacity = capacity;
+	if (persistent)
+	{
+		streamPointer = (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+		if (streamPointer == nullptr)
+		{
+			printf("Could not map the network's vertex buffer persistently, streaming through glBufferSubData instead\n");
+			persistent = false;
+		}
+	}
+	glBindVertexArray(vao);
+	//position
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	//color
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)8);
+	glEnableVertexAttribArray(1);
+}
+
+void NetworkRenderer::StreamVertices(int firstSegment, const std::vector<Vertex>& newVertices)
+{
+	//vertices that are rewritten rather than appended may still be in use by a frame in flight, so they go into new storage
+	//holding a copy of the unchanged ones instead of waiting for those frames
+	bool rewrite = firstSegment < streamedSegments;
+	streamedSegments = firstSegment;
+	if (!newVertices.empty() || rewrite)
+	{
+		ReserveStream(2 * firstSegment + newVertices.size(), rewrite);
+		if (persistent)
+		{
+			//coherent, so written vertices are visible to the next draw without a flush. Nothing in flight reads past vertexCount
+			std::copy(newVertices.begin(), newVertices.end(), streamPointer + 2 * firstSegment);
+		}
+		else
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * 2 * (GLsizeiptr)firstSegment, sizeof(Vertex) * newVertices.size(), newVertices.data());
+		}
+	}
+	streamedSegments = firstSegment + newVertices.size() / 2;
+	vertexCount = 2 * streamedSegments;
+}
+
+void NetworkRenderer::DrawMesh()
+{
+	//the main mesh
+	glBindVertexArray(vao);
+	glDrawArrays(GL_LINES, 0, vertexCount);
+
+	//the AP mesh
+	if (!instancedMarkers)
+	{
+		glBindVertexArray(avao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, aibo);
+		glDrawElements(GL_TRIANGLES, APindexCount, APindexType, (void*)0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
+void NetworkRenderer::DrawMarkers()
+{
+	if (instancedMarkers && markerCount > 0)
+	{
+		glBindVertexArray(avao);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, markerCount);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+#include "RoadNetwork.h"
+#include "Settings.h"
+#include "ThreadPool.h"
+#include "Vertex.h"
+
+//persistent mapping is GL 4.4, beyond the loader's 4.2, so glBufferStorage is loaded by hand when streaming
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+#endif
+
+//GL meshes for a RoadNetwork: the segments as lines, plus the attraction points and starting sites as square markers.
+//The markers are one instance each, expanded by the BasicInstanced shader, or indexed quads when that isn't available
+class NetworkRenderer
+{
+private:
+	bool instancedMarkers;
+	ThreadPool* fillPool;	//not owned, fills ConstructMesh's vertices in parallel
+	GLuint vbo, vao;	//buffer identifiers for primary mesh, two vertices per segment drawn as lines without an index buffer
+	GLuint avbo, avao, aibo;	//buffer identifiers for AP mesh, aibo is only used by the quad fallback
+	int vertexCount;
+	int APindexCount;
+	GLenum APindexType;
+	int markerCount;	//instances in avbo
+	bool streaming;	//the line mesh is appended to as the network grows rather than built once at the end
+	bool persistent;	//streamed vertices are written straight into vbo through streamPointer, otherwise with glBufferSubData
+	PFNGLBUFFERSTORAGEPROC bufferStorage;
+	Vertex* streamPointer;
+	int vertexCapacity;	//vertices vbo has room for when streaming
+	int streamedSegments;	//segments already in vbo
+	std::vector<Vertex> APVertices;
+	std::vector<unsigned int> APIndices;
+	void ReserveStream(int vertices, bool reallocate);	//grows vbo to hold at least this many vertices, keeping the streamed ones. reallocate moves them to new storage even if there is room
+public:
+	NetworkRenderer(bool instanced, ThreadPool* pool);	//instanced needs the BasicInstanced shader, otherwise the markers are drawn as quads with Basic
+	~NetworkRenderer();
+	void ConstructAPMesh(const std::vector<glm::vec2>& attractionPoints, const std::vector<glm::vec2>& sites);	//the initial attraction points, before generation consumes them
+	void ConstructMesh(RoadNetwork* network);	//the whole network at once, once it has been generated
+	void EnableStreaming(GLADloadproc load);	//use StreamVertices instead of ConstructMesh. load finds GL functions beyond the loader's version
+	//replaces the streamed line mesh from firstSegment on with newVertices, two per segment. Only those vertices are uploaded
+	void StreamVertices(int firstSegment, const std::vector<Vertex>& newVertices);
+	//writes segments [first, last) as line vertex pairs from out onwards, reading each straight from the pool. No GL calls
+	static void FillLineVertices(SegmentPool& segments, int first, int last, Vertex* out);
+	void DrawMesh();	//with Basic bound, includes the markers when they aren't instanced
+	void DrawMarkers();	//with BasicInstanced bound, does nothing when the markers aren't instanced
+};
@@ -0,0 +1,75 @@
+#include "Random.h"
+
+//splitmix64, used to spread a seed over the full xoshiro state and to derive stream seeds
+static uint64_t SplitMix64(uint64_t* x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static inline uint64_t RotateLeft(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+Random::Random(uint64_t seed)
+{
+	this->seed = seed;
+	uint64_t x = seed;
+	for (int i = 0; i < 4; i++)
+	{
+		state[i] = SplitMix64(&x);
+	}
+}
+
+uint64_t Random::Seed()
+{
+	return seed;
+}
+
+uint64_t Random::Next()
+{
+	uint64_t result = RotateLeft(state[1] * 5, 7) * 9;
+	uint64_t t = state[1] << 17;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = RotateLeft(state[3], 45);
+	return result;
+}
+
+unsigned int Random::NextBelow(unsigned int bound)
+{
+	//Lemire's multiply and reject, which only rejects when the low half lands in the short final interval
+	uint64_t m = (Next() >> 32) * bound;
+	uint32_t low = (uint32_t)m;
+	if (low < bound)
+	{
+		uint32_t threshold = (uint32_t)(0u - bound) % bound;
+		while (low < threshold)
+		{
+			m = (Next() >> 32) * bound;
+			low = (uint32_t)m;
+		}
+	}
+	return (unsigned int)(m >> 32);
+}
+
+float Random::NextFloat()
+{
+	//top 24 bits, so every value is exactly representable and 1.0 is never returned
+	return (float)(Next() >> 40) * (1.0f / 16777216.0f);
+}
+
+Random Random::Stream(uint64_t index)
+{
+	//hash the index before mixing it in so neighbouring streams don't start from neighbouring splitmix states
+	uint64_t x = index;
+	uint64_t streamSeed = seed ^ SplitMix64(&x);
+	x = streamSeed;
+	return Random(SplitMix64(&x));
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+//xoshiro256** generator. Each RoadNetwork owns one, so a network is reproducible from its seed alone. Parallel work takes
+//its own Stream, keyed by the work item rather than the thread running it, so results don't depend on the thread count
+class Random
+{
+private:
+	uint64_t state[4];
+	uint64_t seed;
+public:
+	Random(uint64_t seed);
+	uint64_t Seed();
+	uint64_t Next();
+	unsigned int NextBelow(unsigned int bound);	//uniform in [0, bound) without the bias of Next() % bound, bound must be > 0
+	float NextFloat();	//uniform in [0, 1)
+	Random Stream(uint64_t index);	//independent generator for the index-th work item, depends only on this generator's seed and index
+};
@@ -2,73 +2,177 @@
 
 using namespace std::chrono;
 
-RoadNetwork::RoadNetwork(MapLayer* map, MapLayer* streets)
+RoadNetwork::RoadNetwork(MapLayer* map, MapLayer* streets, uint64_t seed) : RoadNetwork(map, streets, seed, nullptr)
+{
+}
+
+RoadNetwork::RoadNetwork(MapLayer* map, MapLayer* streets, uint64_t seed, const std::atomic<bool>* cancel)
+{
+	boundsMin = glm::vec2(0.0f, 0.0f);
+	boundsMax = glm::vec2((float)streets->GetWidth(), (float)streets->GetHeight());
+	isRegion = false;
+	Initialise(map, streets, seed, generationThreadCount);
+	cancelFlag = cancel;
+	SetInitialAttractionPoints();
+	PickStartingSegments();
+}
+
+RoadNetwork::RoadNetwork(MapLayer* map, MapLayer* streets, uint64_t seed, glm::vec2 start, AttractionPointSet* points, glm::vec2 regionMin, glm::vec2 regionMax)
+{
+	boundsMin = regionMin;
+	boundsMax = regionMax;
+	isRegion = true;
+	//regions already run one per thread
+	Initialise(map, streets, seed, 1);
+	std::swap(attractionPoints, *points);
+	int base = segments.Add(start, start);
+	segments[base].root = base;
+	startingLocations.push_back(start);
+}
+
+void RoadNetwork::Initialise(MapLayer* map, MapLayer* streets, uint64_t seed, unsigned int threadCount)
 {
 	state = 0;
 	totalConnectors = 0;
 	connectionTime = 0.0;
 	killTime = 0.0;
 	closenessNetworkTime = 0.0;
+	cancelFlag = nullptr;
 	walkability = map;
 	roadAccess = streets;
-	SetInitialAttractionPoints();
-	PickStartingSegments();
-	ConstructAPMesh();
-	GenerateNetwork();
-	ConstructMesh();
-	
+	//segments can overshoot the edge by up to a segment length, so pad the index a little
+	float pad = 2.0f * segmentLength;
+	segmentGrid = new SpatialGrid(boundsMin.x - pad, boundsMin.y - pad, boundsMax.x + pad, boundsMax.y + pad, segmentLength);
+	endIndex = new DynamicGrid(boundsMin.x - pad, boundsMin.y - pad, boundsMax.x + pad, boundsMax.y + pad, interSegmentAttractionThreshold);
+	threadPool = new ThreadPool(threadCount);
+	random = new Random(seed);
 }
 
 RoadNetwork::~RoadNetwork()
 {
-	for (auto& s : segments)
-	{
-		delete s;
-	}
-	glDeleteBuffers(1, &vbo);
-	glDeleteBuffers(1, &ibo);
-	glDeleteBuffers(1, &avbo);
-	glDeleteBuffers(1, &aibo);
+	delete segmentGrid;
+	delete endIndex;
+	delete threadPool;
+	delete random;
 }
 
 void RoadNetwork::PickStartingSegments()
 {
+	if (attractionPoints.Size() == 0)
+	{
+		return;
+	}
 	for (int i = 0; i < startingSegmentCount; i++)
 	{
-		int idx = rand() % attractionPointCount;
+		int idx = random->NextBelow(attractionPoints.Size());
 		//starting segments are 0-length
-		Segment* base = new Segment(attractionPoints[idx].location, attractionPoints[idx].location);
-		base->root = base;
-		segments.push_back(base);
-		startingLocations.push_back(attractionPoints[idx].location);
+		glm::vec2 location = attractionPoints.Location(idx);
+		int base = segments.Add(location, location);
+		segments[base].root = base;
+		startingLocations.push_back(location);
 	}
 }
 
-void RoadNetwork::GenerateClosenessNetwork(std::deque<Segment*>* candidateSegments)
+void RoadNetwork::GenerateClosenessNetwork(std::vector<int>* candidateSegments)
 {
 	high_resolution_clock::time_point t1 = high_resolution_clock::now();
-	//generate initial closeness network
-	for (auto& point : attractionPoints)
+	const DistanceKernels& kernels = GetDistanceKernels();
+	//index the new segments, sizing the cells so there's about one segment per cell however many were added
+	float area = (boundsMax.x - boundsMin.x) * (boundsMax.y - boundsMin.y);
+	int candidateCount = candidateSegments->size();
+	segmentGrid->Reset(std::max(segmentLength, sqrtf(area / (float)std::max(1, candidateCount))));
+	candidateX.clear();
+	candidateY.clear();
+	candidateIds.clear();
+	for (auto& seg : *candidateSegments)
+	{
+		segmentGrid->Insert(seg, segments[seg].end);
+		candidateX.push_back(segments[seg].end.x);
+		candidateY.push_back(segments[seg].end.y);
+		candidateIds.push_back(seg);
+	}
+	segmentGrid->Build();
+	//update the closeness network with the segments added in the last round. Points are split into fixed chunks that each
+	//record the influence they exert, then the chunks are merged in order so the result is the same as a serial pass
+	int chunkCount = (attractionPoints.Size() + closenessChunkSize - 1) / closenessChunkSize;
+	if ((int)closenessChunks.size() < chunkCount)
+	{
+		closenessChunks.resize(chunkCount);
+	}
+	threadPool->ParallelFor(chunkCount, [&](int c)
 	{
-		float closestDistance = point.closest != nullptr ? glm::length(point.location - point.closest->end) : 99999999.9f;	//distance to current closest segment, or an arbitrarily large value
-		for (auto& seg : *candidateSegments)
+		ClosenessChunk& chunk = closenessChunks[c];
+		chunk.influenced.clear();
+		chunk.influenceVectors.clear();
+		chunk.newlyClosest.clear();
+		chunk.scanPoints.clear();
+		chunk.scanX.clear();
+		chunk.scanY.clear();
+		chunk.scanDistSq.clear();
+		chunk.scanIdx.clear();
+		unsigned int first = c * closenessChunkSize;
+		unsigned int last = std::min(attractionPoints.Size(), first + closenessChunkSize);
+		for (unsigned int i = first; i < last; i++)
 		{
-			float currentDistance = glm::length(point.location - seg->end);
-			if (currentDistance < closestDistance)
+			glm::vec2 location = attractionPoints.Location(i);
+			int previousClosest = attractionPoints.closestIdx[i];
+			if (previousClosest != -1 && segmentGrid->CellsWithin(location, sqrtf(attractionPoints.closestDistSq[i])) * gridSearchCellCost < candidateCount)
 			{
-				closestDistance = currentDistance;
-				point.closest = seg;
-				seg->closestFlag = true;
+				//any new segment that is closer than the current closest lies within the current closest distance. Ties go to the lower id,
+				//which always leaves the old closest in place and otherwise matches the in-order scan below
+				if (segmentGrid->Nearest(location, &attractionPoints.closestDistSq[i], &attractionPoints.closestIdx[i]))
+				{
+					chunk.newlyClosest.push_back(attractionPoints.closestIdx[i]);
+				}
+			}
+			else
+			{
+				//first round (no closest yet), or few enough new segments that checking all of them in a batch is cheaper
+				chunk.scanPoints.push_back(i);
+				chunk.scanX.push_back(location.x);
+				chunk.scanY.push_back(location.y);
+				chunk.scanDistSq.push_back(attractionPoints.closestDistSq[i]);
+				chunk.scanIdx.push_back(previousClosest);
 			}
 		}
-		if (point.closest != nullptr)
+		kernels.ClosestCandidate(chunk.scanX.data(), chunk.scanY.data(), chunk.scanDistSq.data(), chunk.scanIdx.data(), chunk.scanPoints.size(),
+			candidateX.data(), candidateY.data(), candidateIds.data(), candidateCount);
+		for (unsigned int s = 0; s < chunk.scanPoints.size(); s++)
 		{
-			//make sure we're not working with a 0-length vector
-			if (point.location != point.closest->end)
+			unsigned int i = chunk.scanPoints[s];
+			if (chunk.scanIdx[s] != attractionPoints.closestIdx[i])
 			{
-				point.closest->influenceVectors.push_back(glm::normalize(point.location - point.closest->end) * point.weightingFactor);
+				attractionPoints.closestIdx[i] = chunk.scanIdx[s];
+				attractionPoints.closestDistSq[i] = chunk.scanDistSq[s];
+				chunk.newlyClosest.push_back(chunk.scanIdx[s]);
 			}
 		}
+		for (unsigned int i = first; i < last; i++)
+		{
+			int closest = attractionPoints.closestIdx[i];
+			if (closest != -1)
+			{
+				glm::vec2 location = attractionPoints.Location(i);
+				//make sure we're not working with a 0-length vector
+				if (location != segments[closest].end)
+				{
+					chunk.influenced.push_back(closest);
+					chunk.influenceVectors.push_back(glm::normalize(location - segments[closest].end) * attractionPoints.weight[i]);
+				}
+			}
+		}
+	});
+	for (int c = 0; c < chunkCount; c++)
+	{
+		ClosenessChunk& chunk = closenessChunks[c];
+		for (auto& seg : chunk.newlyClosest)
+		{
+			segments[seg].closestFlag = true;
+		}
+		for (unsigned int i = 0; i < chunk.influenced.size(); i++)
+		{
+			AddInfluence(chunk.influenced[i], chunk.influenceVectors[i]);
+		}
 	}
 	high_resolution_clock::time_point t2 = high_resolution_clock::now();
 	duration<double> time_span = duration_cast<duration<double>>(t2 - t1);
@@ -76,130 +180,363 @@ void RoadNetwork::GenerateClosenessNetwork(std::deque<Segment*>* candidateSegmen
 }
 
 void RoadNetwork::GenerateNetwork()
+{
+	//we assume that PickStartingSegments() has been called already - since it's just generating our voronoi sites
+	if (partitionByRegion && segments.Size() > 1)
+	{
+		GrowRegions();
+	}
+	else
+	{
+		GrowNetwork();
+	}
+	if (IsCancelled())
+	{
+		printf("Generation cancelled with %i segments\n", segments.Size());
+		return;
+	}
+	int connectedFrom = segments.Size();
+	PostGenerationConnection();
+	if (roundCallback)
+	{
+		roundCallback(connectedFrom);
+	}
+	PrintSummaryStatistics();
+}
+
+void RoadNetwork::SetRoundCallback(std::function<void(int)> callback)
+{
+	roundCallback = callback;
+}
+
+void RoadNetwork::SetCancelFlag(const std::atomic<bool>* flag)
+{
+	cancelFlag = flag;
+}
+
+bool RoadNetwork::IsCancelled()
+{
+	return cancelFlag != nullptr && cancelFlag->load();
+}
+
+void RoadNetwork::GrowNetwork()
 {
 	//initialise variables
-	int remainingAttractionPoints = attractionPointCount;
+	int remainingAttractionPoints = attractionPoints.Size();
 	int remainingAttractionPointsAtLastIter = remainingAttractionPoints;
 	int noProgressCount = 0;
-	std::deque<Segment*> segmentsAddedInLastRound;
+	std::vector<int> segmentsAddedInLastRound;
 
-	//initialise network (we assume that PickStartingSegments() has been called already - since it's just generating our voronoi sites)
-	for (auto& seg : segments)
+	//initialise network
+	for (int i = 0; i < segments.Size(); i++)
 	{
-		segmentsAddedInLastRound.push_back(seg);
+		segmentsAddedInLastRound.push_back(i);
 	}
 	//build segments until we have connected just about every point or we have gone for a while without connecting anything new
-	while (remainingAttractionPoints > 1 && noProgressCount < 20)
+	while (remainingAttractionPoints > 1 && noProgressCount < 20 && !IsCancelled())
 	{
 		PrintStateUpdate();
-		//regenerate the closeness map from newly added segments
-		GenerateClosenessNetwork(&segmentsAddedInLastRound);
-		//remove any points where the network has colonised their space
-		KillPointsNearSegments();
-		//check all of the recently added segments and see if we want to attract them to one another
-		//InGenerationConnection(&segmentsAddedInLastRound);
-		//Add a new set of segments for this round
-		AddNewSegmentSet(&segmentsAddedInLastRound);
-		//move the newly created segments into the main collection
-		for (auto& n : segmentsAddedInLastRound)
+		int roundStart = segments.Size();
+		GenerationRound(&segmentsAddedInLastRound);
+		if (roundCallback)
 		{
-			segments.push_back(n);
+			roundCallback(roundStart);
 		}
-		remainingAttractionPoints = attractionPoints.size();
+		remainingAttractionPoints = attractionPoints.Size();
 		if (remainingAttractionPoints == remainingAttractionPointsAtLastIter)
 		{
 			noProgressCount++;
 		}
+		else if (isRegion)
+		{
+			//a region grows from one site, so it often goes a few rounds between connecting points - only give up on a long run of them
+			noProgressCount = 0;
+		}
 		remainingAttractionPointsAtLastIter = remainingAttractionPoints;
 	}
-	PrintSummaryStatistics();
-	PostGenerationConnection();
 }
 
-void RoadNetwork::AddNewSegmentSet(std::deque<Segment*>* segmentsAddedInLastRound)
+void RoadNetwork::GrowRegions()
 {
-	segmentsAddedInLastRound->clear();
-	for (auto& v : segments)
+	//every point belongs to the region of its nearest starting site (ties to the lower site), i.e. the sites' Voronoi cells
+	int regionCount = segments.Size();
+	std::vector<AttractionPointSet> regionPoints(regionCount);
+	std::vector<glm::vec2> regionMin(regionCount), regionMax(regionCount);
+	for (int r = 0; r < regionCount; r++)
+	{
+		regionMin[r] = segments[r].end;
+		regionMax[r] = segments[r].end;
+	}
+	for (unsigned int i = 0; i < attractionPoints.Size(); i++)
 	{
-		if (v->influenceVectors.size() > 0)
+		glm::vec2 location = attractionPoints.Location(i);
+		int nearest = 0;
+		float nearestDistSq = std::numeric_limits<float>::max();
+		for (int r = 0; r < regionCount; r++)
 		{
-			glm::vec2 sumVector = glm::vec2(0.0f, 0.0f);
-			for (auto& vec : v->influenceVectors)
+			glm::vec2 d = location - segments[r].end;
+			float distSq = d.x * d.x + d.y * d.y;
+			if (distSq < nearestDistSq)
 			{
-				sumVector = sumVector + vec;
+				nearestDistSq = distSq;
+				nearest = r;
 			}
+		}
+		regionPoints[nearest].Add(location, attractionPoints.weight[i]);
+		regionMin[nearest] = glm::min(regionMin[nearest], location);
+		regionMax[nearest] = glm::max(regionMax[nearest], location);
+	}
+	//grow the regions independently, one per work item, each with its own generator seeded from this one
+	std::vector<RoadNetwork*> regions(regionCount);
+	for (int r = 0; r < regionCount; r++)
+	{
+		regions[r] = new RoadNetwork(walkability, roadAccess, random->Next(), segments[r].end, &regionPoints[r], regionMin[r], regionMax[r]);
+		regions[r]->SetCancelFlag(cancelFlag);
+	}
+	threadPool->ParallelFor(regionCount, [&](int r)
+	{
+		regions[r]->GrowNetwork();
+	});
+	//then join them back up in region order, so the result doesn't depend on which finished first
+	segments = SegmentPool();
+	attractionPoints = AttractionPointSet();
+	for (int r = 0; r < regionCount; r++)
+	{
+		segments.Append(regions[r]->segments);
+		for (unsigned int i = 0; i < regions[r]->attractionPoints.Size(); i++)
+		{
+			attractionPoints.Add(regions[r]->attractionPoints.Location(i), regions[r]->attractionPoints.weight[i]);
+		}
+		closenessNetworkTime += regions[r]->closenessNetworkTime;
+		killTime += regions[r]->killTime;
+		connectionTime += regions[r]->connectionTime;
+		delete regions[r];
+	}
+	printf("%i regions grown, %i points remain\n", regionCount, attractionPoints.Size());
+	if (roundCallback)
+	{
+		roundCallback(0);	//the regions are only seen once joined, and joining reorders every segment
+	}
+	//the borders between regions are stitched together by PostGenerationConnection, which joins close ends of different roots
+}
+
+void RoadNetwork::GenerationRound(std::vector<int>* segmentsAddedInLastRound)
+{
+	//regenerate the closeness map from newly added segments
+	GenerateClosenessNetwork(segmentsAddedInLastRound);
+	//remove any points where the network has colonised their space
+	KillPointsNearSegments();
+	//check all of the recently added segments and see if we want to attract them to other networks
+	if (connectDuringGeneration)
+	{
+		InGenerationConnection(segmentsAddedInLastRound);
+	}
+	//Add a new set of segments for this round
+	AddNewSegmentSet(segmentsAddedInLastRound);
+}
+
+void RoadNetwork::AddInfluence(int seg, glm::vec2 influence)
+{
+	Segment& s = segments[seg];
+	if (s.influenceCount == 0)
+	{
+		s.firstInfluence = influence;
+		newlyInfluenced.push_back(seg);
+	}
+	s.influenceSum = s.influenceSum + influence;
+	s.influenceCount++;
+}
+
+void RoadNetwork::AddNewSegmentSet(std::vector<int>* segmentsAddedInLastRound)
+{
+	segmentsAddedInLastRound->clear();
+	//merge the newly influenced segments into the frontier, keeping it in index order so segments grow in the same order as a full scan
+	std::sort(newlyInfluenced.begin(), newlyInfluenced.end());
+	unsigned int oldFrontierSize = growthFrontier.size();
+	growthFrontier.insert(growthFrontier.end(), newlyInfluenced.begin(), newlyInfluenced.end());
+	std::inplace_merge(growthFrontier.begin(), growthFrontier.begin() + oldFrontierSize, growthFrontier.end());
+	newlyInfluenced.clear();
+	//work out where every frontier segment would grow to and check the whole path against the maps, in fixed chunks
+	unsigned int frontierSize = growthFrontier.size();
+	growthStarts.resize(frontierSize);
+	growthTargets.resize(frontierSize);
+	growthDirections.resize(frontierSize);
+	growthAccessibility.resize(frontierSize);
+	int chunkCount = (frontierSize + growthChunkSize - 1) / growthChunkSize;
+	growthChunkCounts.resize(chunkCount);
+	threadPool->ParallelFor(chunkCount, [&](int c)
+	{
+		int first = c * growthChunkSize;
+		int count = std::min(growthChunkSize, (int)frontierSize - first);
+		for (int f = first; f < first + count; f++)
+		{
+			Segment& v = segments[growthFrontier[f]];
+			glm::vec2 sumVector = v.influenceSum;
 			//there is a risk we have 2 influence vectors that are opposite one another
 			if (glm::length(sumVector) < 1.0f)
 			{
-				sumVector = v->influenceVectors[0];
+				sumVector = v.firstInfluence;
 			}
 			//normalise sv
 			sumVector = glm::normalize(sumVector);
-			//create and attach a new segment
-			glm::vec2 target = v->end + (sumVector * segmentLength);
-			float sLength = segmentLength * roadAccess->AccessibilityBetweenPoints(v->end, target);
-			if (sLength > 0.1f)	//only bother to create the segment if it's gonna go anywhere
+			growthDirections[f] = sumVector;
+			growthStarts[f] = v.end;
+			growthTargets[f] = v.end + (sumVector * segmentLength);
+		}
+		roadAccess->AccessibilityAlongLines(&growthStarts[first], &growthTargets[first], &growthAccessibility[first], count, walkability, slopeAccessibilityFactor);
+		int grown = 0;
+		for (int f = first; f < first + count; f++)
+		{
+			//only bother to create the segment if it's gonna go anywhere
+			grown += segmentLength * growthAccessibility[f] > 0.1f ? 1 : 0;
+		}
+		growthChunkCounts[c] = grown;
+	});
+	//give each chunk its range of new segment ids and of the remaining frontier, in frontier order, so the chunks can
+	//attach their segments in parallel and still number them exactly as a serial pass would
+	int totalGrown = 0;
+	for (int c = 0; c < chunkCount; c++)
+	{
+		int grown = growthChunkCounts[c];
+		growthChunkCounts[c] = totalGrown;
+		totalGrown += grown;
+	}
+	int firstNew = segments.AddMany(totalGrown);
+	segmentsAddedInLastRound->resize(totalGrown);
+	remainingFrontier.resize(frontierSize - totalGrown);
+	threadPool->ParallelFor(chunkCount, [&](int c)
+	{
+		int first = c * growthChunkSize;
+		int count = std::min(growthChunkSize, (int)frontierSize - first);
+		int added = growthChunkCounts[c];
+		int remaining = first - added;
+		for (int f = first; f < first + count; f++)
+		{
+			int i = growthFrontier[f];
+			float sLength = segmentLength * growthAccessibility[f];
+			if (sLength > 0.1f)
 			{
-				Segment* sPrime = new Segment(v->end, v->end + (sumVector * sLength));
-				sPrime->parent = v;
-				sPrime->root = v->root;
-				v->children.push_back(sPrime);
-				segmentsAddedInLastRound->push_back(sPrime);
-				v->influenceVectors.clear();
+				//every frontier segment is a different parent, so chunks never touch the same segments
+				Segment& v = segments[i];
+				int sPrime = firstNew + added;
+				segments[sPrime].start = v.end;
+				segments[sPrime].end = v.end + (growthDirections[f] * sLength);
+				segments.AttachChild(i, sPrime);
+				(*segmentsAddedInLastRound)[added] = sPrime;
+				v.influenceSum = glm::vec2(0.0f, 0.0f);
+				v.influenceCount = 0;
+				added++;
+			}
+			else
+			{
+				//it stays on the frontier and keeps accumulating influence
+				remainingFrontier[remaining] = i;
+				remaining++;
 			}
 		}
-	}
+	});
+	growthFrontier.swap(remainingFrontier);
 }
 
 void RoadNetwork::KillPointsNearSegments()
 {
 	high_resolution_clock::time_point t1 = high_resolution_clock::now();
-	std::vector<AttractionPoint> rPoints;
-	for (auto& p : attractionPoints)
-	{
-		//the closeness network has just been generated, so each point should now be tracking its closest segment
-		if (glm::length(p.location - p.closest->end) > killDistance)
-		{
-			rPoints.push_back(p);
-		}
-	}
-	attractionPoints.clear();
-	attractionPoints = rPoints;
+	//the closeness network has just been generated, so each point already knows how far it is from its closest segment
+	pointAlive.resize(attractionPoints.Size());
+	GetDistanceKernels().MarkBeyond(attractionPoints.closestDistSq.data(), pointAlive.data(), attractionPoints.Size(), killDistance * killDistance);
+	attractionPoints.Compact(pointAlive);
 	high_resolution_clock::time_point t2 = high_resolution_clock::now();
 	duration<double> time_span = duration_cast<duration<double>>(t2 - t1);
 	killTime += time_span.count();
 }
 
-void RoadNetwork::InGenerationConnection(std::deque<Segment*>* segmentsAddedInLastRound)
+void RoadNetwork::InGenerationConnection(std::vector<int>* segmentsAddedInLastRound)
 {
 	high_resolution_clock::time_point t1 = high_resolution_clock::now();
+	//index last round's segments alongside everything grown before them, so each new end can look at every segment near it
 	for (auto& seg : *segmentsAddedInLastRound)
 	{
-		if (!seg->closestFlag)
+		endIndex->Insert(seg, segments[seg].end);
+	}
+	//query in fixed chunks, then apply the results in chunk order so they don't depend on the thread count
+	int addedCount = segmentsAddedInLastRound->size();
+	int chunkCount = (addedCount + growthChunkSize - 1) / growthChunkSize;
+	if ((int)connectionChunks.size() < chunkCount)
+	{
+		connectionChunks.resize(chunkCount);
+	}
+	threadPool->ParallelFor(chunkCount, [&](int c)
+	{
+		ConnectionChunk& chunk = connectionChunks[c];
+		chunk.connections.clear();
+		chunk.influenced.clear();
+		chunk.influenceVectors.clear();
+		int last = std::min(addedCount, (c + 1) * growthChunkSize);
+		for (int i = c * growthChunkSize; i < last; i++)
 		{
-			//it wasn't close to a point, but it might be close to another segment
-			//the trouble with this check is that maybe it should be attracted to another segment that wasn't added in the last round
-			for (auto& seg2 : *segmentsAddedInLastRound)
+			int seg = (*segmentsAddedInLastRound)[i];
+			if (segments[seg].closestFlag)
+			{
+				continue;
+			}
+			//it wasn't close to a point, but it might be close to another network
+			chunk.nearby.clear();
+			endIndex->QueryRadius(segments[seg].end, interSegmentAttractionThreshold, &chunk.nearby);
+			std::sort(chunk.nearby.begin(), chunk.nearby.end());
+			//join the closest one in reach, otherwise be pulled towards all of them
+			int nearest = -1;
+			float nearestDistSq = segmentConnectionThreshold * segmentConnectionThreshold;
+			for (auto& other : chunk.nearby)
 			{
-				if (seg->root != seg2->root)
+				if (segments[seg].root != segments[other].root)
 				{
-
-					float dist = glm::length(seg->end - seg2->end);
-					if (dist < segmentConnectionThreshold)
+					glm::vec2 offset = segments[other].end - segments[seg].end;
+					float distSq = glm::dot(offset, offset);
+					if (distSq < nearestDistSq)
 					{
-						Segment* connector = new Segment(seg->end, seg2->end);
-						connector->parent = seg;
-						connector->root = seg->root;
-						connector->col = connCol;
-						totalConnectors++;
-						segments.push_back(connector);
-					}
-					else if (dist < interSegmentAttractionThreshold)
-					{
-						seg->influenceVectors.push_back(seg2->end - seg->end);
+						nearest = other;
+						nearestDistSq = distSq;
 					}
 				}
 			}
+			if (nearest != -1)
+			{
+				chunk.connections.push_back(std::make_pair(seg, nearest));
+				continue;
+			}
+			for (auto& other : chunk.nearby)
+			{
+				if (segments[seg].root != segments[other].root)
+				{
+					chunk.influenced.push_back(seg);
+					chunk.influenceVectors.push_back(segments[other].end - segments[seg].end);
+				}
+			}
+		}
+	});
+	for (int c = 0; c < chunkCount; c++)
+	{
+		ConnectionChunk& chunk = connectionChunks[c];
+		for (auto& connection : chunk.connections)
+		{
+			//two new ends can pick each other, only join them once
+			bool joined = false;
+			for (int child = segments[connection.second].firstChild; child != -1; child = segments[child].nextSibling)
+			{
+				joined = joined || (segments[child].col == connCol && segments[child].end == segments[connection.first].end);
+			}
+			if (!joined)
+			{
+				int connector = segments.Add(segments[connection.first].end, segments[connection.second].end);
+				segments.AttachChild(connection.first, connector);
+				segments[connector].col = connCol;
+				segments[connection.second].childCount++;
+				totalConnectors++;
+			}
+		}
+		for (unsigned int i = 0; i < chunk.influenced.size(); i++)
+		{
+			AddInfluence(chunk.influenced[i], chunk.influenceVectors[i]);
 		}
 	}
 	high_resolution_clock::time_point t2 = high_resolution_clock::now();
@@ -209,181 +546,135 @@ void RoadNetwork::InGenerationConnection(std::deque<Segment*>* segmentsAddedInLa
 
 void RoadNetwork::PostGenerationConnection()
 {
-	int totalConnectors = 0;
-	//build the list of all end point segments
-	std::vector<Segment*> childFree;
-	for (auto& seg : segments)
+	high_resolution_clock::time_point t1 = high_resolution_clock::now();
+	//build the list of all end point segments, and index their ends with cells the size of the connection distance
+	std::vector<int> childFree;
+	segmentGrid->Reset(segmentConnectionThreshold);
+	for (int i = 0; i < segments.Size(); i++)
 	{
-		if (seg->children.size() == 0)
+		if (segments[i].childCount == 0 && segments[i].col != connCol)
 		{
-			childFree.push_back(seg);
+			childFree.push_back(i);
+			segmentGrid->Insert(i, segments[i].end);
 		}
 	}
-	for (auto& cf : childFree)
+	segmentGrid->Build();
+	//find every close pair from different starting networks once, as (lower, higher) id, in fixed chunks so nothing is
+	//added to the network while it's being read and the pairs come out in the same order on any number of threads
+	int chunkCount = (childFree.size() + connectionChunkSize - 1) / connectionChunkSize;
+	std::vector<std::vector<std::pair<int, int>>> chunkPairs(chunkCount);
+	threadPool->ParallelFor(chunkCount, [&](int c)
 	{
-		for (auto& target : childFree)
+		std::vector<int> nearby;
+		std::vector<std::pair<int, int>>& pairs = chunkPairs[c];
+		unsigned int last = std::min((unsigned int)childFree.size(), (unsigned int)((c + 1) * connectionChunkSize));
+		for (unsigned int i = c * connectionChunkSize; i < last; i++)
 		{
-			//make sure that the segment we are currently looking at still hasn't been connected and that the segments are from different starting networks
-			if (cf->root != target->root)	//banning same root is too conservative, but no restriction is too permissive
+			int cf = childFree[i];
+			nearby.clear();
+			segmentGrid->QueryRadius(segments[cf].end, segmentConnectionThreshold, &nearby);
+			std::sort(nearby.begin(), nearby.end());
+			for (auto& target : nearby)
 			{
-				float dist = glm::length(cf->end - target->end);
-				if (dist < segmentConnectionThreshold)
+				if (target > cf && segments[cf].root != segments[target].root)	//banning same root is too conservative, but no restriction is too permissive
 				{
-					Segment* connector = new Segment(cf->end, target->end);
-					connector->parent = cf;
-					connector->root = cf->root;
-					connector->col = connCol;
-					cf->children.push_back(connector);
-					target->children.push_back(connector);
-					totalConnectors++;
-					segments.push_back(connector);
+					pairs.push_back(std::make_pair(cf, target));
 				}
 			}
 		}
-	}
-	printf("%i total connectors\n", totalConnectors);
-}
-
-void RoadNetwork::SetInitialAttractionPoints()
-{
-	int xRange = 1024;
-	int yRange = 1024;
-	int x, y;
-	for (unsigned int i = 0; i < attractionPointCount; i++)
+	});
+	for (auto& pairs : chunkPairs)
 	{
-		x = rand() % xRange;
-		y = rand() % yRange;
-		//while (!walkability->Walkable(x, y))
-		while(roadAccess->RoadScaleFactorFromColor(roadAccess->ColorLookup(x, y)) == IMPASSIBLE)
+		for (auto& pair : pairs)
 		{
-			x = rand() % xRange;
-			y = rand() % yRange;
+			int connector = segments.Add(segments[pair.first].end, segments[pair.second].end);
+			segments.AttachChild(pair.first, connector);
+			segments[connector].col = connCol;
+			segments[pair.second].childCount++;
+			totalConnectors++;
 		}
-		AttractionPoint p(glm::vec2((float)x, (float)y));
-		p.weightingFactor = roadAccess->RoadScaleFactorFromColor(roadAccess->ColorLookup(x, y));
-		attractionPoints.push_back(p);
 	}
-	printf("%i points generated\n", attractionPoints.size());
+	high_resolution_clock::time_point t2 = high_resolution_clock::now();
+	duration<double> time_span = duration_cast<duration<double>>(t2 - t1);
+	connectionTime += time_span.count();
 }
 
-void RoadNetwork::ConstructAPMesh()
+void RoadNetwork::SetInitialAttractionPoints()
 {
-	if (attractionPoints.size() > 0)
+	SamplingTable table(roadAccess, weightSamplingByRoadClass, threadPool);
+	if (table.Empty())
+	{
+		printf("The road map has no passable pixels, no points generated\n");
+		return;
+	}
+	if (IsCancelled())
 	{
-		int i = 0;
-		for (auto& ap : attractionPoints)
+		return;
+	}
+	//each chunk samples its share of the points from its own stream, then the chunks are joined in order
+	int chunkCount = (attractionPointCount + samplingChunkSize - 1) / samplingChunkSize;
+	sampledChunks.resize(chunkCount);
+	threadPool->ParallelFor(chunkCount, [&](int c)
+	{
+		Random stream = random->Stream(c);
+		AttractionPointSet& chunk = sampledChunks[c];
+		chunk = AttractionPointSet();
+		if (IsCancelled())
 		{
-			glm::vec2 currentPoint = ap.location;
-			Vertex v0 = Vertex(glm::vec4(currentPoint.x, currentPoint.y, 0.0f, 1.0f), apCol);
-			Vertex v1 = Vertex(glm::vec4(currentPoint.x + 1.0f, currentPoint.y, 0.0f, 1.0f), apCol);
-			Vertex v2 = Vertex(glm::vec4(currentPoint.x + 1.0f, currentPoint.y + 1.0f, 0.0f, 1.0f), apCol);
-			Vertex v3 = Vertex(glm::vec4(currentPoint.x, currentPoint.y + 1.0f, 0.0f, 1.0f), apCol);
-			APVertices.push_back(v0);
-			APVertices.push_back(v1);
-			APVertices.push_back(v2);
-			APVertices.push_back(v3);
-			APIndices.push_back(i * 4);
-			APIndices.push_back(i * 4 + 1);
-			APIndices.push_back(i * 4 + 2);
-			APIndices.push_back(i * 4);
-			APIndices.push_back(i * 4 + 2);
-			APIndices.push_back(i * 4 + 3);
-			i++;
+			return;	//the network is being thrown away, so it doesn't matter which chunks are missing
 		}
-		if (segments.size() > 0)
+		unsigned int count = std::min(samplingChunkSize, attractionPointCount - c * samplingChunkSize);
+		for (unsigned int i = 0; i < count; i++)
 		{
-			for (auto& seg : segments)
-			{
-				glm::vec2 currentPoint = seg->end;
-				Vertex v0 = Vertex(glm::vec4(currentPoint.x - 2.0f, currentPoint.y - 2.0f, 0.0f, 1.0f), siteCol);
-				Vertex v1 = Vertex(glm::vec4(currentPoint.x + 2.0f, currentPoint.y - 2.0f, 0.0f, 1.0f), siteCol);
-				Vertex v2 = Vertex(glm::vec4(currentPoint.x + 2.0f, currentPoint.y + 2.0f, 0.0f, 1.0f), siteCol);
-				Vertex v3 = Vertex(glm::vec4(currentPoint.x - 2.0f, currentPoint.y + 2.0f, 0.0f, 1.0f), siteCol);
-				APVertices.push_back(v0);
-				APVertices.push_back(v1);
-				APVertices.push_back(v2);
-				APVertices.push_back(v3);
-				APIndices.push_back(i * 4);
-				APIndices.push_back(i * 4 + 1);
-				APIndices.push_back(i * 4 + 2);
-				APIndices.push_back(i * 4);
-				APIndices.push_back(i * 4 + 2);
-				APIndices.push_back(i * 4 + 3);
-				i++;
-			}
+			float roadScale;
+			glm::ivec2 pixel = table.Sample(&stream, &roadScale);
+			chunk.Add(glm::vec2((float)pixel.x, (float)pixel.y), roadScale);
 		}
-		APindexCount = APIndices.size();
-		glGenVertexArrays(1, &avao);
-		glGenBuffers(1, &avbo);
-		glBindVertexArray(avao);
-		glBindBuffer(GL_ARRAY_BUFFER, avbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * APVertices.size(), &APVertices[0], GL_STATIC_DRAW);
-		//position
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
-		glEnableVertexAttribArray(0);
-		//color
-		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)16);
-		glEnableVertexAttribArray(1);
-		glGenBuffers(1, &aibo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, aibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * APIndices.size(), &APIndices[0], GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	}
-}
-
-void RoadNetwork::ConstructMesh()
-{
-	if (segments.size() > 0)
-	{
-		for (unsigned int i = 0; i < segments.size(); i++)
+	});
+	for (auto& chunk : sampledChunks)
+	{
+		for (unsigned int i = 0; i < chunk.Size(); i++)
 		{
-			Segment s = *segments[i];
-			Vertex v0 = Vertex(glm::vec4(s.start.x, s.start.y, 0.0f, 1.0f), s.col);
-			Vertex v1 = Vertex(glm::vec4(s.end.x, s.end.y, 0.0f, 1.0f), s.col);
-			vertices.push_back(v0);
-			vertices.push_back(v1);
-			indices.push_back(2 * i);
-			indices.push_back((2 * i) + 1);
+			attractionPoints.Add(chunk.Location(i), chunk.weight[i]);
 		}
-		indexCount = indices.size();
-		glGenVertexArrays(1, &vao);
-		glGenBuffers(1, &vbo);
-		glBindVertexArray(vao);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
-		//position
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
-		glEnableVertexAttribArray(0);
-		//color
-		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)16);
-		glEnableVertexAttribArray(1);
-		glGenBuffers(1, &ibo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), &indices[0], GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	}
-}
-
-void RoadNetwork::DrawMesh()
-{
-	//the main mesh
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glDrawElements(GL_LINES, indexCount, GL_UNSIGNED_INT, (void*)0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-	//the AP mesh
-	glBindVertexArray(avao);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, aibo);
-	glDrawElements(GL_TRIANGLES, APindexCount, GL_UNSIGNED_INT, (void*)0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	sampledChunks.clear();
+	printf("%i points generated\n", attractionPoints.Size());
+}
+
+SegmentPool* RoadNetwork::GetSegments()
+{
+	return &segments;
+}
+
+AttractionPointSet* RoadNetwork::GetAttractionPoints()
+{
+	return &attractionPoints;
+}
+
+bool RoadNetwork::WriteSegments(const char* path)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	//one segment per line, links are indices into the same list and -1 for none
+	file << "id,startX,startY,endX,endY,parent,root,connector\n";
+	for (int i = 0; i < segments.Size(); i++)
+	{
+		Segment& s = segments[i];
+		file << s.id << ',' << s.start.x << ',' << s.start.y << ',' << s.end.x << ',' << s.end.y << ',';
+		file << s.parent << ',' << s.root << ',' << (s.col == connCol ? 1 : 0) << '\n';
+	}
+	return file.good();
 }
 
 void RoadNetwork::PrintSummaryStatistics()
 {
 	printf("\n--Generation Finished--\n");
 	printf("%i total connectors\n", totalConnectors);
-	printf("%i total segments\n", segments.size());
+	printf("%i total segments\n", segments.Size());
 	printf("Closeness networks took %f seconds\n", closenessNetworkTime);
 	printf("Interconnectivity added %f seconds\n", connectionTime);
 	printf("Attraction point removal took %f seconds\n", killTime);
@@ -391,19 +682,23 @@ void RoadNetwork::PrintSummaryStatistics()
 
 void RoadNetwork::PrintStateUpdate()
 {
-	if (state == 0 && attractionPoints.size() < attractionPointCount / 2)
+	if (isRegion)
+	{
+		return;
+	}
+	if (state == 0 && attractionPoints.Size() < attractionPointCount / 2)
 	{
-		printf("%i points remain\n", attractionPoints.size());
+		printf("%i points remain\n", attractionPoints.Size());
 		state++;
 	}
-	else if (state == 1 && attractionPoints.size() < attractionPointCount / 4)
+	else if (state == 1 && attractionPoints.Size() < attractionPointCount / 4)
 	{
-		printf("%i points remain\n", attractionPoints.size());
+		printf("%i points remain\n", attractionPoints.Size());
 		state++;
 	}
-	else if (state == 2 && attractionPoints.size() < attractionPointCount / 8)
+	else if (state == 2 && attractionPoints.Size() < attractionPointCount / 8)
 	{
-		printf("%i points remain\n", attractionPoints.size());
+		printf("%i points remain\n", attractionPoints.Size());
 		state++;
 	}
 }
@@ -411,10 +706,147 @@ void RoadNetwork::PrintStateUpdate()
 
 Segment::Segment(glm::vec2 pos1, glm::vec2 pos2)
 {
-	this->root = nullptr;
-	this->parent = nullptr;
+	this->id = -1;
+	this->root = -1;
+	this->parent = -1;
+	firstChild = -1;
+	nextSibling = -1;
+	childCount = 0;
+	influenceSum = glm::vec2(0.0f, 0.0f);
+	firstInfluence = glm::vec2(0.0f, 0.0f);
+	influenceCount = 0;
 	this->start = pos1;
 	this->end = pos2;
 	closestFlag = false;
 	col = roadCol;
+}
+
+SegmentPool::SegmentPool()
+{
+	count = 0;
+}
+
+SegmentPool::SegmentPool(const SegmentPool& other)
+{
+	count = 0;
+	*this = other;
+}
+
+SegmentPool& SegmentPool::operator=(const SegmentPool& other)
+{
+	if (this != &other)
+	{
+		blocks.resize(other.blocks.size());
+		for (unsigned int b = 0; b < blocks.size(); b++)
+		{
+			blocks[b].reserve(1 << BlockShift);
+			blocks[b].assign(other.blocks[b].begin(), other.blocks[b].end());
+		}
+		count = other.count;
+	}
+	return *this;
+}
+
+int SegmentPool::Add(glm::vec2 start, glm::vec2 end)
+{
+	//blocks are reserved up front and never grow past it, so existing segments never move
+	if ((count >> BlockShift) == (int)blocks.size())
+	{
+		blocks.push_back(std::vector<Segment>());
+		blocks.back().reserve(1 << BlockShift);
+	}
+	blocks.back().push_back(Segment(start, end));
+	blocks.back().back().id = count;
+	return count++;
+}
+
+int SegmentPool::AddMany(int n)
+{
+	int first = count;
+	for (int i = 0; i < n; i++)
+	{
+		Add(glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 0.0f));
+	}
+	return first;
+}
+
+int SegmentPool::Append(SegmentPool& other)
+{
+	int offset = count;
+	for (int i = 0; i < other.Size(); i++)
+	{
+		Segment& s = other[i];
+		Segment& copy = (*this)[Add(s.start, s.end)];
+		int id = copy.id;
+		copy = s;
+		copy.id = id;
+		copy.parent = s.parent == -1 ? -1 : s.parent + offset;
+		copy.root = s.root == -1 ? -1 : s.root + offset;
+		copy.firstChild = s.firstChild == -1 ? -1 : s.firstChild + offset;
+		copy.nextSibling = s.nextSibling == -1 ? -1 : s.nextSibling + offset;
+	}
+	return offset;
+}
+
+void SegmentPool::AttachChild(int parent, int child)
+{
+	Segment& p = (*this)[parent];
+	Segment& c = (*this)[child];
+	c.parent = parent;
+	c.root = p.root;
+	c.nextSibling = p.firstChild;
+	p.firstChild = child;
+	p.childCount++;
+}
+
+int SegmentPool::Size()
+{
+	return count;
+}
+
+Segment& SegmentPool::operator[](int i)
+{
+	return blocks[i >> BlockShift][i & ((1 << BlockShift) - 1)];
+}
+
+void AttractionPointSet::Add(glm::vec2 loc, float weightingFactor)
+{
+	x.push_back(loc.x);
+	y.push_back(loc.y);
+	closestIdx.push_back(-1);
+	closestDistSq.push_back(std::numeric_limits<float>::max());
+	weight.push_back(weightingFactor);
+}
+
+unsigned int AttractionPointSet::Size()
+{
+	return x.size();
+}
+
+glm::vec2 AttractionPointSet::Location(unsigned int i)
+{
+	return glm::vec2(x[i], y[i]);
+}
+
+void AttractionPointSet::Compact(std::vector<unsigned char>& alive)
+{
+	//move the surviving points down over the dead ones, keeping their order, without reallocating
+	unsigned int remaining = 0;
+	for (unsigned int i = 0; i < x.size(); i++)
+	{
+		if (alive[i])
+		{
+			x[remaining] = x[i];
+			y[remaining] = y[i];
+			closestIdx[remaining] = closestIdx[i];
+			closestDistSq[remaining] = closestDistSq[i];
+			weight[remaining] = weight[i];
+			remaining++;
+		}
+	}
+	x.resize(remaining);
+	y.resize(remaining);
+	closestIdx.resize(remaining);
+	closestDistSq.resize(remaining);
+	weight.resize(remaining);
 }
\ No newline at end of file
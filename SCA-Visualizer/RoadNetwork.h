@@ -1,13 +1,21 @@
 #pragma once
 
-#include "glm\glm.hpp"
-#include "glad/glad.h"
-#include <deque>
+#include "glm/glm.hpp"
+#include <limits>
 #include <vector>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <fstream>
+#include <functional>
+#include "DistanceKernels.h"
+#include "DynamicGrid.h"
 #include "MapLayer.h"
+#include "Random.h"
+#include "SamplingTable.h"
 #include "Settings.h"
-#include "Vertex.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
 
 static unsigned int attractionPointCount = 10000;
 static float segmentLength = 8.0f;			//Generation time significantly increases as this value decreases
@@ -15,77 +23,169 @@ static float killDistance = 4.0f;			//Dropping this below 5 increases generation
 static int startingSegmentCount = 8;
 static float interSegmentAttractionThreshold = 50.0f;
 static float segmentConnectionThreshold = 20.0f;
+static unsigned int generationThreadCount = 0;	//0 uses every hardware thread, 1 keeps generation on the calling thread
+static int gridSearchCellCost = 16;		//how many candidate checks in the batched distance kernel cost about the same as searching one grid cell
+static int closenessChunkSize = 2048;		//attraction points per parallel work item, the work split (and so the result) doesn't depend on the thread count
+static float slopeAccessibilityFactor = 0.25f;	//how strongly climbing cuts a segment's length, it stops entirely once the climb per unit length reaches 1 / this - 0 ignores the height map. Climb is in HeightLookup units (the colour sum over HeightScalingFactor) from the gradient field, MaxmimalSlope's alpha field plays no part
+static int growthChunkSize = 1024;		//frontier segments per parallel work item when checking where they can grow
+static bool weightSamplingByRoadClass = false;	//place attraction points in proportion to road class rather than uniformly over passable ground
+static unsigned int samplingChunkSize = 4096;	//attraction points sampled per parallel work item, each chunk draws from its own random stream
+//Each round, a new end that isn't closest to any point checks every end of another starting network within the attraction
+//threshold, old or new. It joins only the nearest within segmentConnectionThreshold, with a connector counted as a child of
+//both ends so neither is free for PostGenerationConnection, and then takes no influence. Otherwise it is pulled towards each
+//of them. The original pass's connector per pair, with influence alongside, runs away once older ends are in reach
+static bool connectDuringGeneration = true;
+static int connectionChunkSize = 2048;		//end segments per parallel work item when looking for connections after generation
+static bool partitionByRegion = false;	//grow each starting site's Voronoi cell as a separate network, one per thread, then stitch them together at the borders
 
 class Segment
 {
 private:
 public:
 	Segment(glm::vec2 pos1, glm::vec2 pos2);
+	int id;	//index into the SegmentPool that owns it
 	glm::vec4 col;
 	glm::vec2 start;
 	glm::vec2 end;
-	Segment* parent;
-	Segment* root;
-	std::deque<Segment*> children;
-	std::vector<glm::vec2> influenceVectors;
+	int parent;	//parent, root and child links are SegmentPool indices, -1 for none
+	int root;
+	int firstChild;
+	int nextSibling;
+	int childCount;	//also counts connectors from other networks that end on this segment
+	glm::vec2 influenceSum;	//sum of the influence vectors pulling on the segment's end since it last grew
+	glm::vec2 firstInfluence;	//fallback direction for when the sum cancels out
+	int influenceCount;
 	bool closestFlag; //if the segment was added in the last round, we also check it against other recently added segments
 };
 
-class AttractionPoint
+//Owns every segment of a network, allocated in large blocks that are never moved, so a whole network is built and freed
+//with a handful of allocations. Segments refer to one another by index
+class SegmentPool
+{
+private:
+	std::vector<std::vector<Segment>> blocks;
+	int count;
+public:
+	static const int BlockShift = 14;	//16384 segments per block
+	SegmentPool();
+	SegmentPool(const SegmentPool& other);
+	SegmentPool& operator=(const SegmentPool& other);	//copies reserve full blocks too, so the copy's segments never move either
+	int Add(glm::vec2 start, glm::vec2 end);	//returns the new segment's index
+	int AddMany(int n);	//adds n segments to be positioned by the caller, returns the index of the first
+	int Append(SegmentPool& other);	//copies every segment of other onto the end with its links shifted to match, returns where they start
+	void AttachChild(int parent, int child);	//links child under parent and gives it the parent's root
+	int Size();
+	Segment& operator[](int i);
+};
+
+//Attraction points stored as parallel arrays, so the per-round distance and kill loops stream through plain floats
+class AttractionPointSet
+{
+private:
+public:
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<int> closestIdx;	//id of the closest segment, -1 until the first closeness pass
+	std::vector<float> closestDistSq;	//squared distance to the end of the closest segment
+	std::vector<float> weight;
+	void Add(glm::vec2 loc, float weightingFactor);
+	unsigned int Size();
+	glm::vec2 Location(unsigned int i);
+	void Compact(std::vector<unsigned char>& alive);	//removes every point whose alive entry is 0
+};
+
+//Output of the closeness pass for one chunk of attraction points, merged back into the segments in point order
+class ClosenessChunk
 {
 private:
 public:
-	glm::vec2 location;
-	Segment* closest;
-	float weightingFactor;
-	AttractionPoint(glm::vec2 loc)
-	{
-		location = loc;
-		closest = nullptr;
-		weightingFactor = 1.0f;
-	}
+	std::vector<int> influenced;
+	std::vector<glm::vec2> influenceVectors;
+	std::vector<int> newlyClosest;
+	std::vector<unsigned int> scanPoints;	//points checked against every new segment rather than through the grid, gathered for the batch kernel
+	std::vector<float> scanX, scanY, scanDistSq;
+	std::vector<int> scanIdx;
+};
+
+//Output of the in-generation connection pass for one chunk of new segments, applied to the network in chunk order
+class ConnectionChunk
+{
+private:
+public:
+	std::vector<std::pair<int, int>> connections;	//(new segment, the other network's segment it joins)
+	std::vector<int> influenced;
+	std::vector<glm::vec2> influenceVectors;
+	std::vector<int> nearby;	//query results, kept to reuse the allocation
 };
 
 class MajorRoad
 {
 private:
 public:
-	std::vector<Segment*> segments;
+	std::vector<int> segments;
 };
 
+//Generates the network on the CPU only, NetworkRenderer builds the meshes for it when there is a GL context
 class RoadNetwork
 {
 private:
 	int state;
+	bool isRegion;	//one region of a partitioned network, which doesn't report progress
 	int totalConnectors;
 	double connectionTime, killTime, closenessNetworkTime;
-	GLuint vbo, vao, ibo;	//buffer identifiers for primary mesh
-	GLuint avbo, avao, aibo;	//buffer identifiers for AP mesh
-	int indexCount;
-	int APindexCount;
-	std::deque<Segment*> segments;
-	std::vector<Vertex> vertices;
-	std::vector<int> indices;
-	std::vector<Vertex> APVertices;
-	std::vector<int> APIndices;
-	std::vector<AttractionPoint> attractionPoints;
+	SegmentPool segments;
+	std::vector<int> growthFrontier;	//segments with pending influence, in index order, which are the only ones that can grow
+	std::vector<int> newlyInfluenced;	//segments that picked up their first influence since the frontier was last updated
+	std::vector<glm::vec2> growthStarts, growthTargets, growthDirections;	//where each frontier segment would grow to this round, in frontier order
+	std::vector<float> growthAccessibility;
+	std::vector<int> growthChunkCounts;	//segments grown by each chunk of the frontier, then where each chunk's new segments start
+	std::vector<int> remainingFrontier;	//the frontier segments that couldn't grow this round, becomes the next frontier
+	SpatialGrid* segmentGrid;
+	DynamicGrid* endIndex;	//the end of every segment grown so far (not connectors), added to each round
+	std::vector<ConnectionChunk> connectionChunks;
+	ThreadPool* threadPool;
+	Random* random;
+	std::vector<ClosenessChunk> closenessChunks;
+	std::vector<float> candidateX, candidateY;	//end points of the segments added in the last round
+	std::vector<int> candidateIds;	//end points of the segments added in the last round, used to find the points they are now closest to
+	AttractionPointSet attractionPoints;
+	std::vector<unsigned char> pointAlive;
+	std::vector<AttractionPointSet> sampledChunks;
 	MapLayer* walkability;
 	MapLayer* roadAccess;
-	void ConstructAPMesh();
-	void ConstructMesh();
+	glm::vec2 boundsMin, boundsMax;	//area the network grows in, the whole map unless it is one region of a partitioned network
+	std::function<void(int)> roundCallback;
+	const std::atomic<bool>* cancelFlag;	//shared with the regions of a partitioned network
+	//one region of a partitioned network, grown from a single starting site on the calling thread. Takes the points, leaving the set empty
+	RoadNetwork(MapLayer* map, MapLayer* streets, uint64_t seed, glm::vec2 start, AttractionPointSet* points, glm::vec2 regionMin, glm::vec2 regionMax);
+	void Initialise(MapLayer* map, MapLayer* streets, uint64_t seed, unsigned int threadCount);
 	void PickStartingSegments();
-	void GenerateClosenessNetwork(std::deque<Segment*>* candidateSegments);
-	void InGenerationConnection(std::deque<Segment*>* segmentsAddedInLastRound);
+	void AddInfluence(int seg, glm::vec2 influence);
+	void GenerateClosenessNetwork(std::vector<int>* candidateSegments);
+	void InGenerationConnection(std::vector<int>* segmentsAddedInLastRound);
 	void PostGenerationConnection();
 	void KillPointsNearSegments();
-	void AddNewSegmentSet(std::deque<Segment*>* segmentsAddedInLastRound);
+	void AddNewSegmentSet(std::vector<int>* segmentsAddedInLastRound);
+	void GenerationRound(std::vector<int>* segmentsAddedInLastRound);	//grows the network by one segment length, replacing the list with this round's segments
+	void GrowNetwork();	//generation rounds until the points run out or stop being connected
+	void GrowRegions();	//the same, but each starting site's region grows separately and in parallel
+	friend class RoadNetworkBenchmark;	//runs the generation stages one at a time
 public:
 	std::vector<glm::vec2> startingLocations;
-	RoadNetwork(MapLayer* map, MapLayer* streets);
+	RoadNetwork(MapLayer* map, MapLayer* streets, uint64_t seed);	//the same seed and maps always give the same network
+	RoadNetwork(MapLayer* map, MapLayer* streets, uint64_t seed, const std::atomic<bool>* cancel);	//with a cancel flag that also covers sampling the points
 	~RoadNetwork();
 	void SetInitialAttractionPoints();
 	void GenerateNetwork();
-	void DrawMesh();
+	//called on the generating thread whenever segments have been added, with the index of the first segment that is new or
+	//changed since the last call. Segments are only ever appended while growing, so it is usually the size before the round
+	void SetRoundCallback(std::function<void(int)> callback);
+	//generation stops after the round in progress once the flag is set, from any thread, skipping the connection pass
+	void SetCancelFlag(const std::atomic<bool>* flag);
+	bool IsCancelled();
+	SegmentPool* GetSegments();
+	AttractionPointSet* GetAttractionPoints();
+	bool WriteSegments(const char* path);	//writes the finished network as csv, returns false if the file couldn't be written
 	void PrintSummaryStatistics();
 	void PrintStateUpdate();
 };
\ No newline at end of file
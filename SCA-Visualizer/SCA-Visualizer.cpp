@@ -4,11 +4,15 @@
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "glm/glm.hpp"
-#include "glm\gtc\matrix_transform.hpp"
+#include "glm/gtc/matrix_transform.hpp"
 #include "time.h"
 #include <iostream>
+#include <memory>
 #include <vector>
+#include "GenerationWorker.h"
 #include "MapLayer.h"
+#include "MapRenderer.h"
+#include "NetworkRenderer.h"
 #include "RoadNetwork.h"
 #include "Shader.h"
 #include "Vertex.h"
@@ -19,15 +23,26 @@ bool shouldExit = false;
 int screenWidth = 1024, screenHeight = 1024;
 
 Shader* basic = nullptr;
+Shader* basicInstanced = nullptr;
 Shader* texturedUnlit = nullptr;
-int uBProjMatrix, uBModelMatrix, uTProjMatrix, uTModelMatrix, uTex;
+int uBProjMatrix, uBModelMatrix, uBIProjMatrix, uBIModelMatrix, uTProjMatrix, uTModelMatrix, uTex;
 
 MapLayer* heightLayer;
 MapLayer* streetLayer;
-RoadNetwork* network;
+MapRenderer* heightRenderer;
+MapRenderer* streetRenderer;
+NetworkRenderer* networkRenderer;
+ThreadPool* renderPool;	//the render thread's own work, loading the maps and filling meshes, started once with as many threads as generation
+GenerationWorker* generator;
+GenerationParameters parameters;
+int latestRun = 0;	//the run being shown or about to be, snapshots from earlier runs are dropped
+int displayedRun = 0;	//the run networkRenderer holds
+double runStartTime = 0.0;
+std::vector<glm::vec2> startingLocations;	//of the displayed run
 Voronoi* voro;
 bool showVoronoiOverlay = false;
 bool showNetworkOverlay = true;
+bool streamGrowth = true;	//draw the network as it grows rather than once it has finished
 int layerToDraw = 0;
 
 void error_callback(int error, const char* description)
@@ -35,6 +50,12 @@ void error_callback(int error, const char* description)
 	fprintf(stderr, "Error: %s\n", description);
 }
 
+void startGeneration()
+{
+	latestRun = generator->Restart(parameters);
+	runStartTime = glfwGetTime();
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
@@ -44,17 +65,27 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	if (key == GLFW_KEY_V && action == GLFW_PRESS)
 	{
 		//generate a voronoi diagram
-		if (voro == nullptr)
+		if (voro == nullptr && !startingLocations.empty())
 		{
-			voro = new Voronoi(0.1f, network->startingLocations, 0.0f, (float)screenWidth - 1.0f, 0.0f, (float)screenHeight - 1.0f);
+			voro = new Voronoi(0.1f, startingLocations, 0.0f, (float)screenWidth - 1.0f, 0.0f, (float)screenHeight - 1.0f);
 			voro->BuildMesh();
 			showVoronoiOverlay = true;
 		}
-		else
+		else if (voro != nullptr)
 		{
 			showVoronoiOverlay = !showVoronoiOverlay;
 		}
 	}
+	if (key == GLFW_KEY_R && action == GLFW_PRESS)
+	{
+		//start again with the next seed, the current run is abandoned
+		parameters.seed++;
+		startGeneration();
+	}
+	if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		generator->Cancel();
+	}
 	if (key == GLFW_KEY_N && action == GLFW_PRESS)
 	{
 		showNetworkOverlay = !showNetworkOverlay;
@@ -112,11 +143,17 @@ void init_GL()
 	}
 	//load shaders
 	basic = new Shader();
-	basic->compileShaderFromFile("./Data/Shaders/basic.vert", VERTEX);
-	basic->compileShaderFromFile("./Data/Shaders/basic.frag", FRAGMENT);
+	basic->compileShaderFromFile("./Data/Shaders/Basic.vert", VERTEX);
+	basic->compileShaderFromFile("./Data/Shaders/Basic.frag", FRAGMENT);
 	basic->linkAndValidate();
 	uBProjMatrix = basic->getUniformLocation("projectionViewMatrix");
 	uBModelMatrix = basic->getUniformLocation("modelMatrix");
+	basicInstanced = new Shader();
+	basicInstanced->compileShaderFromFile("./Data/Shaders/BasicInstanced.vert", VERTEX);
+	basicInstanced->compileShaderFromFile("./Data/Shaders/Basic.frag", FRAGMENT);
+	basicInstanced->linkAndValidate();
+	uBIProjMatrix = basicInstanced->getUniformLocation("projectionViewMatrix");
+	uBIModelMatrix = basicInstanced->getUniformLocation("modelMatrix");
 	texturedUnlit = new Shader();
 	texturedUnlit->compileShaderFromFile("./Data/Shaders/TexturedUnlit.vert", VERTEX);
 	texturedUnlit->compileShaderFromFile("./Data/Shaders/TexturedUnlit.frag", FRAGMENT);
@@ -142,20 +179,25 @@ void draw()
 	texturedUnlit->setUniform(uTex, 0);
 	if (layerToDraw == 0)
 	{
-		heightLayer->Draw();
+		heightRenderer->Draw();
 	}
 	else
 	{
-		streetLayer->Draw();
+		streetRenderer->Draw();
 	}
 	
 
 	basic->use();
 	basic->setUniform(uBModelMatrix, modelview);
 	basic->setUniform(uBProjMatrix, projection);
-	if (showNetworkOverlay)
+	if (showNetworkOverlay && networkRenderer != nullptr)
 	{
-		network->DrawMesh();
+		networkRenderer->DrawMesh();
+		basicInstanced->use();
+		basicInstanced->setUniform(uBIModelMatrix, modelview);
+		basicInstanced->setUniform(uBIProjMatrix, projection);
+		networkRenderer->DrawMarkers();
+		basic->use();
 	}
 
 	if (showVoronoiOverlay)
@@ -170,15 +212,35 @@ void draw()
 
 void exit()
 {
+	if (generator != nullptr)
+	{
+		delete generator;	//waits for the round in progress, the layers below must outlive it
+		generator = nullptr;
+	}
 	if (voro != nullptr)
 	{
 		delete voro;
 		voro = nullptr;
 	}
-	if (network != nullptr)
+	if (networkRenderer != nullptr)
 	{
-		delete network;
-		network = nullptr;
+		delete networkRenderer;
+		networkRenderer = nullptr;
+	}
+	if (renderPool != nullptr)
+	{
+		delete renderPool;
+		renderPool = nullptr;
+	}
+	if (heightRenderer != nullptr)
+	{
+		delete heightRenderer;
+		heightRenderer = nullptr;
+	}
+	if (streetRenderer != nullptr)
+	{
+		delete streetRenderer;
+		streetRenderer = nullptr;
 	}
 	if (heightLayer != nullptr)
 	{
@@ -195,6 +257,11 @@ void exit()
 		delete basic;
 		basic = nullptr;
 	}
+	if (basicInstanced != nullptr)
+	{
+		delete basicInstanced;
+		basicInstanced = nullptr;
+	}
 	if (texturedUnlit != nullptr)
 	{
 		delete texturedUnlit;
@@ -203,31 +270,91 @@ void exit()
 	glfwTerminate();
 }
 
-void generateData()
+bool generateData(const char* heightPath, const char* streetPath, uint64_t seed)
 {
 	//load the map data
-	heightLayer = new MapLayer("D:\\Data\\Topographical\\AucklandTest.tga", 1024, 1024, MAPTYPE_HEIGHT);
-	streetLayer = new MapLayer("D:\\Data\\Topographical\\OSM Images\\AucklandOSMScale2.tga", 1024, 1024, MAPTYPE_ROADS);
-	//streetLayer = new MapLayer("D:\\Data\\Topographical\\OSM Images\\AucklandOtherScale.tga", 1024, 1024, MAPTYPE_ROADS);
-	//generate the network
-	int sTime = (int)time(NULL);
-	network = new RoadNetwork(heightLayer, streetLayer);
-	int tTime = (int)time(NULL) - sTime;
-	printf("Generation time: %i\n", tTime);
+	renderPool = new ThreadPool(generationThreadCount);
+	heightLayer = new MapLayer(heightPath, 1024, 1024, MAPTYPE_HEIGHT, renderPool);
+	streetLayer = new MapLayer(streetPath, 1024, 1024, MAPTYPE_ROADS, renderPool);
+	//streetLayer = new MapLayer("D:\\Data\\Topographical\\OSM Images\\AucklandOtherScale.tga", 1024, 1024, MAPTYPE_ROADS, renderPool);
+	if (!heightLayer->IsLoaded() || !streetLayer->IsLoaded())
+	{
+		printf("Could not load the maps %s and %s\n", heightPath, streetPath);
+		return false;
+	}
+	heightRenderer = new MapRenderer(heightLayer);
+	streetRenderer = new MapRenderer(streetLayer);
+	//the network is generated on the worker thread and picked up a snapshot at a time by consumeSnapshots
+	generator = new GenerationWorker(heightLayer, streetLayer);
+	parameters.seed = seed;
+	parameters.streamRounds = streamGrowth;
+	startGeneration();
+	return true;
 }
 
-int main()
+void consumeSnapshots()
 {
+	//never waits, whatever the generator has published since the last frame is streamed in
+	while (std::unique_ptr<NetworkSnapshot> snapshot = generator->TakeSnapshot())
+	{
+		if (snapshot->run != latestRun)
+		{
+			continue;	//from a run that has since been restarted
+		}
+		if (snapshot->run != displayedRun)
+		{
+			//the first snapshot of a new run, start over from its attraction points
+			delete networkRenderer;
+			networkRenderer = new NetworkRenderer(basicInstanced->isLinked(), renderPool);
+			if (parameters.streamRounds)
+			{
+				networkRenderer->EnableStreaming((GLADloadproc)glfwGetProcAddress);
+			}
+			networkRenderer->ConstructAPMesh(snapshot->attractionPoints, snapshot->startingLocations);
+			startingLocations = snapshot->startingLocations;
+			if (voro != nullptr)
+			{
+				delete voro;
+				voro = nullptr;
+				showVoronoiOverlay = false;
+			}
+			displayedRun = snapshot->run;
+		}
+		if (snapshot->network)
+		{
+			networkRenderer->ConstructMesh(snapshot->network.get());
+		}
+		else
+		{
+			networkRenderer->StreamVertices(snapshot->firstSegment, snapshot->vertices);
+		}
+		if (snapshot->finished)
+		{
+			printf("Generation time: %.2fs\n", glfwGetTime() - runStartTime);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	//map paths and a seed can be given on the command line, otherwise the Auckland test data is used with a seed from the clock
+	const char* heightPath = argc > 2 ? argv[1] : "D:\\Data\\Topographical\\AucklandTest.tga";
+	const char* streetPath = argc > 2 ? argv[2] : "D:\\Data\\Topographical\\OSM Images\\AucklandOSMScale2.tga";
+	uint64_t seed = argc > 3 ? strtoull(argv[3], nullptr, 10) : (uint64_t)time(NULL);
 	if (!init_GLFW())
 	{
 		return -1;
 	}
 	init_GL();
-	srand((unsigned int)(time(NULL)));
-	generateData();
+	if (!generateData(heightPath, streetPath, seed))
+	{
+		exit();
+		return -1;
+	}
 	/* Loop until the user closes the window */
 	while (!shouldExit && !glfwWindowShouldClose(mainWindow))
 	{
+		consumeSnapshots();
 		draw();
 		glfwPollEvents();
 	}
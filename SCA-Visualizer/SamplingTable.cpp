@@ -0,0 +1,202 @@
+#include "SamplingTable.h"
+
+SamplingTable::SamplingTable(MapLayer* roads, bool weightByRoadClass, ThreadPool* pool)
+{
+	this->roads = roads;
+	width = roads->GetWidth();
+	tileSize = 0;
+	tilesX = 0;
+	int64_t counts[ClassCount] = { 0 };
+	if (roads->IsTiled())
+	{
+		CountTileClasses(counts, pool);
+	}
+	else
+	{
+		CountClasses(counts);
+	}
+	passableCount = 0;
+	double weights[ClassCount];
+	for (int k = 0; k < ClassCount; k++)
+	{
+		passableCount += counts[k];
+		weights[k] = (double)counts[k] * (weightByRoadClass ? RoadClassScale[k] : 1.0);
+	}
+	BuildAliasTable(weights, ClassCount, aliasProbability, alias);
+}
+
+void SamplingTable::CountClasses(int64_t* counts)
+{
+	int height = roads->GetHeight();
+	//counting sort the passable pixels by class
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char c = roads->RoadClassLookup(x, y);
+			if (c < ClassCount)
+			{
+				counts[c]++;
+			}
+		}
+	}
+	classStart[0] = 0;
+	for (int k = 0; k < ClassCount; k++)
+	{
+		classStart[k + 1] = classStart[k] + (int)counts[k];	//untiled maps are small enough for int
+	}
+	pixels.resize(classStart[ClassCount]);
+	int fill[ClassCount];
+	std::copy(classStart, classStart + ClassCount, fill);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char c = roads->RoadClassLookup(x, y);
+			if (c < ClassCount)
+			{
+				pixels[fill[c]++] = x + width * y;
+			}
+		}
+	}
+}
+
+void SamplingTable::CountTileClasses(int64_t* counts, ThreadPool* pool)
+{
+	tileSize = roads->GetTileSize();
+	tilesX = (width + tileSize - 1) / tileSize;
+	int tileCount = tilesX * ((roads->GetHeight() + tileSize - 1) / tileSize);
+	std::vector<int> tileCounts(tileCount * ClassCount, 0);	//tile t's count of class c is at t * ClassCount + c
+	pool->ParallelFor(tileCount, [&](int t)
+	{
+		std::shared_ptr<const MapTile> tile = roads->TileAt((t % tilesX) * tileSize, (t / tilesX) * tileSize);
+		for (auto& c : tile->roadClasses)
+		{
+			if (c < ClassCount)
+			{
+				tileCounts[t * ClassCount + c]++;
+			}
+		}
+	});
+	std::vector<double> weights(tileCount);
+	for (int k = 0; k < ClassCount; k++)
+	{
+		for (int t = 0; t < tileCount; t++)
+		{
+			counts[k] += tileCounts[t * ClassCount + k];
+			weights[t] = (double)tileCounts[t * ClassCount + k];
+		}
+		tileAliasProbability[k].resize(tileCount);
+		tileAlias[k].resize(tileCount);
+		BuildAliasTable(&weights[0], tileCount, &tileAliasProbability[k][0], &tileAlias[k][0]);
+	}
+	std::fill(classStart, classStart + ClassCount + 1, 0);
+}
+
+void SamplingTable::BuildAliasTable(const double* weights, int count, float* probability, int* alias)
+{
+	//Vose's alias method: every column holds its own entry with probability, otherwise its alias. Built in double so
+	//totals over billions of pixels keep their precision, only the final probabilities are stored as float
+	double total = 0.0;
+	for (int k = 0; k < count; k++)
+	{
+		total += weights[k];
+	}
+	std::vector<int> small, large;
+	std::vector<double> scaled(count);
+	for (int k = 0; k < count; k++)
+	{
+		scaled[k] = total > 0.0 ? weights[k] * count / total : 0.0;
+		alias[k] = k;
+		probability[k] = 1.0f;
+		if (scaled[k] < 1.0)
+		{
+			small.push_back(k);
+		}
+		else
+		{
+			large.push_back(k);
+		}
+	}
+	while (!small.empty() && !large.empty())
+	{
+		int s = small.back();
+		small.pop_back();
+		int l = large.back();
+		probability[s] = (float)scaled[s];
+		alias[s] = l;
+		scaled[l] -= 1.0 - scaled[s];
+		if (scaled[l] < 1.0)
+		{
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	//whatever is left over is 1 up to rounding and keeps its own entry, unless rounding stranded an empty one there
+	for (auto& s : small)
+	{
+		if (weights[s] <= 0.0)
+		{
+			for (int k = 0; k < count; k++)
+			{
+				if (weights[k] > 0.0)
+				{
+					probability[s] = 0.0f;
+					alias[s] = k;
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool SamplingTable::Empty()
+{
+	return passableCount == 0;
+}
+
+int64_t SamplingTable::PassableCount()
+{
+	return passableCount;
+}
+
+glm::ivec2 SamplingTable::Sample(Random* random, float* roadScale)
+{
+	int c = random->NextBelow(ClassCount);
+	if (random->NextFloat() >= aliasProbability[c])
+	{
+		c = alias[c];
+	}
+	*roadScale = RoadClassScale[c];
+	if (tileSize > 0)
+	{
+		return SampleTile(random, c);
+	}
+	int p = pixels[classStart[c] + random->NextBelow(classStart[c + 1] - classStart[c])];
+	return glm::ivec2(p % width, p / width);
+}
+
+glm::ivec2 SamplingTable::SampleTile(Random* random, int c)
+{
+	int t = random->NextBelow((unsigned int)tileAlias[c].size());
+	if (random->NextFloat() >= tileAliasProbability[c][t])
+	{
+		t = tileAlias[c][t];
+	}
+	int x0 = (t % tilesX) * tileSize;
+	int y0 = (t / tilesX) * tileSize;
+	int w = std::min(tileSize, width - x0);
+	int h = std::min(tileSize, roads->GetHeight() - y0);
+	//the tile is known to hold the class, so this ends - after tile area / class count tries on average. Pixels are
+	//classified straight from the map rather than through the tile cache, which random tiles would only thrash
+	while (true)
+	{
+		int x = x0 + (int)random->NextBelow(w);
+		int y = y0 + (int)random->NextBelow(h);
+		glm::vec4 col = roads->ColorLookup(x, y);
+		if (MapLayer::RoadClassFromColor((int)col.r, (int)col.g, (int)col.b) == c)
+		{
+			return glm::ivec2(x, y);
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <stdint.h>
+#include <vector>
+#include "MapLayer.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+//Passable pixels of a road layer grouped by road class, built with a single scan of the map. A sample picks a class with
+//an alias table, weighted by how many pixels it has (times the class's road scale when weighting by class), then a pixel
+//of that class uniformly - so every sample is O(1) and impassable pixels are never drawn
+//Tiled road layers are too big to list every pixel, so only each tile's class counts are kept. A class's pixel is then
+//drawn by picking a tile with another alias table, weighted by its count of the class, and rejection sampling within it
+class SamplingTable
+{
+private:
+	static const int ClassCount = ROADCLASS_IMPASSIBLE;	//every class before impassable can be sampled
+	MapLayer* roads;
+	int width;
+	int64_t passableCount;	//64 bit, as tiled maps can have more passable pixels than an int holds
+	std::vector<int> pixels;	//pixel indices, grouped by class
+	int classStart[ClassCount + 1];	//pixels of class c are [classStart[c], classStart[c + 1])
+	float aliasProbability[ClassCount];
+	int alias[ClassCount];
+	int tileSize, tilesX;	//tiled layers only
+	std::vector<float> tileAliasProbability[ClassCount];
+	std::vector<int> tileAlias[ClassCount];
+	void CountClasses(int64_t* counts);
+	void CountTileClasses(int64_t* counts, ThreadPool* pool);
+	static void BuildAliasTable(const double* weights, int count, float* probability, int* alias);
+	glm::ivec2 SampleTile(Random* random, int c);
+public:
+	SamplingTable(MapLayer* roads, bool weightByRoadClass, ThreadPool* pool);	//pool counts the tiles of tiled layers
+	bool Empty();
+	int64_t PassableCount();
+	glm::ivec2 Sample(Random* random, float* roadScale);	//a passable pixel, and the road scale factor it was classified with
+};
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "glm\glm.hpp"
+#include "glm/glm.hpp"
 
 const static glm::vec4 vCol = glm::vec4(1.0f, 0.0f, 1.0f, 1.0f);
 const static glm::vec4 roadCol = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
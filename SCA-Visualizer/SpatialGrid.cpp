@@ -0,0 +1,139 @@
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid(float minX, float minY, float maxX, float maxY, float cellSize)
+{
+	this->minX = minX;
+	this->minY = minY;
+	this->maxX = maxX;
+	this->maxY = maxY;
+	Reset(cellSize);
+}
+
+void SpatialGrid::Reset(float cellSize)
+{
+	this->cellSize = cellSize;
+	cellsX = std::max(1, (int)ceil((maxX - minX) / cellSize));
+	cellsY = std::max(1, (int)ceil((maxY - minY) / cellSize));
+	cellStart.assign(cellsX * cellsY + 1, 0);
+	entryIds.clear();
+	entryPositions.clear();
+	stagedIds.clear();
+	stagedPositions.clear();
+}
+
+int SpatialGrid::CellX(float x)
+{
+	//anything outside the grid is clamped into the border cells
+	int cx = (int)floor((x - minX) / cellSize);
+	return std::min(std::max(cx, 0), cellsX - 1);
+}
+
+int SpatialGrid::CellY(float y)
+{
+	int cy = (int)floor((y - minY) / cellSize);
+	return std::min(std::max(cy, 0), cellsY - 1);
+}
+
+void SpatialGrid::Insert(int id, glm::vec2 pos)
+{
+	stagedIds.push_back(id);
+	stagedPositions.push_back(pos);
+}
+
+void SpatialGrid::Build()
+{
+	//counting sort of the staged entries by cell, which keeps insertion order within each cell
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+	stagedCells.resize(stagedIds.size());
+	for (unsigned int i = 0; i < stagedIds.size(); i++)
+	{
+		stagedCells[i] = CellX(stagedPositions[i].x) + cellsX * CellY(stagedPositions[i].y);
+		cellStart[stagedCells[i]]++;
+	}
+	for (unsigned int c = 1; c < cellStart.size(); c++)
+	{
+		cellStart[c] += cellStart[c - 1];
+	}
+	entryIds.resize(stagedIds.size());
+	entryPositions.resize(stagedIds.size());
+	for (int i = (int)stagedIds.size() - 1; i >= 0; i--)
+	{
+		//cellStart[c] currently holds the end of cell c, filling backwards leaves it pointing at the start
+		int at = --cellStart[stagedCells[i]];
+		entryIds[at] = stagedIds[i];
+		entryPositions[at] = stagedPositions[i];
+	}
+}
+
+int SpatialGrid::CellsWithin(glm::vec2 pos, float radius)
+{
+	int w = CellX(pos.x + radius) - CellX(pos.x - radius) + 1;
+	int h = CellY(pos.y + radius) - CellY(pos.y - radius) + 1;
+	return w * h;
+}
+
+bool SpatialGrid::Nearest(glm::vec2 pos, float* bestDistSq, int* bestId)
+{
+	bool improved = false;
+	int cx = CellX(pos.x);
+	int cy = CellY(pos.y);
+	int maxRing = std::max(std::max(cx, cellsX - 1 - cx), std::max(cy, cellsY - 1 - cy));
+	//search outwards one ring of cells at a time, every cell in ring k is at least (k - 1) cells away from pos
+	for (int ring = 0; ring <= maxRing; ring++)
+	{
+		float ringDistance = (ring - 1) * cellSize;
+		if (ring > 0 && ringDistance * ringDistance > *bestDistSq)
+		{
+			break;
+		}
+		int x0 = cx - ring, x1 = cx + ring;
+		int y0 = cy - ring, y1 = cy + ring;
+		for (int y = std::max(y0, 0); y <= std::min(y1, cellsY - 1); y++)
+		{
+			//interior rows of the ring only contain the two end cells
+			int step = (y == y0 || y == y1) ? 1 : x1 - x0;
+			for (int x = x0; x <= x1; x += step)
+			{
+				if (x < 0 || x >= cellsX)
+				{
+					continue;
+				}
+				int cidx = x + cellsX * y;
+				for (int i = cellStart[cidx]; i < cellStart[cidx + 1]; i++)
+				{
+					float dx = pos.x - entryPositions[i].x;
+					float dy = pos.y - entryPositions[i].y;
+					float d = dx * dx + dy * dy;
+					if (d < *bestDistSq || (d == *bestDistSq && entryIds[i] < *bestId))
+					{
+						*bestDistSq = d;
+						*bestId = entryIds[i];
+						improved = true;
+					}
+				}
+			}
+		}
+	}
+	return improved;
+}
+
+void SpatialGrid::QueryRadius(glm::vec2 pos, float radius, std::vector<int>* ids)
+{
+	int x0 = CellX(pos.x - radius), x1 = CellX(pos.x + radius);
+	int y0 = CellY(pos.y - radius), y1 = CellY(pos.y + radius);
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			int cidx = x + cellsX * y;
+			for (int i = cellStart[cidx]; i < cellStart[cidx + 1]; i++)
+			{
+				glm::vec2 offset = pos - entryPositions[i];
+				if (glm::dot(offset, offset) < radius * radius)
+				{
+					ids->push_back(entryIds[i]);
+				}
+			}
+		}
+	}
+}
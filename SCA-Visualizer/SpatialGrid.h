@@ -0,0 +1,33 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//Uniform grid over a set of 2D positions (segment end points), used to restrict nearest/radius searches to nearby cells
+//Entries are identified by an integer id supplied by the caller. Inserts are staged, and Build() packs them cell by cell
+//into flat arrays so a search walks contiguous memory - call it after the last Insert and before searching
+class SpatialGrid
+{
+private:
+	float minX, minY, maxX, maxY;
+	float cellSize;
+	int cellsX, cellsY;
+	std::vector<int> cellStart;	//entries of cell c are [cellStart[c], cellStart[c + 1])
+	std::vector<int> entryIds;
+	std::vector<glm::vec2> entryPositions;	//kept alongside the ids so a search doesn't have to chase the owning object
+	std::vector<int> stagedIds;
+	std::vector<glm::vec2> stagedPositions;
+	std::vector<int> stagedCells;
+	int CellX(float x);
+	int CellY(float y);
+public:
+	SpatialGrid(float minX, float minY, float maxX, float maxY, float cellSize);
+	void Reset(float cellSize);	//removes every entry and re-divides the same area with a new cell size
+	void Insert(int id, glm::vec2 pos);
+	void Build();
+	int CellsWithin(glm::vec2 pos, float radius);	//number of cells a search of the given radius would touch
+	bool Nearest(glm::vec2 pos, float* bestDistSq, int* bestId);	//improves (bestDistSq, bestId) if an entry is closer (ties go to the lower id), returns true if it changed
+	void QueryRadius(glm::vec2 pos, float radius, std::vector<int>* ids);	//appends the id of every entry strictly within radius of pos
+};
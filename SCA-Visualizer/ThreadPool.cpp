@@ -0,0 +1,108 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	generation = 0;
+	stopping = false;
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	//the calling thread works too, so it counts as one of the threads
+	for (unsigned int i = 1; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		stopping = true;
+	}
+	workReady.notify_all();
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+}
+
+unsigned int ThreadPool::ThreadCount()
+{
+	return workers.size() + 1;
+}
+
+void ThreadPool::ParallelFor(int chunkCount, std::function<void(int)> chunk)
+{
+	if (workers.empty() || chunkCount <= 1)
+	{
+		for (int i = 0; i < chunkCount; i++)
+		{
+			chunk(i);
+		}
+		return;
+	}
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->task = chunk;
+	job->taskCount = chunkCount;
+	job->nextTask = 0;
+	job->tasksRemaining = chunkCount;
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		currentJob = job;
+		generation++;
+	}
+	workReady.notify_all();
+	RunTasks(job.get());
+	//wait for the last chunks to finish. Workers still holding the job can only find it empty from here on
+	std::unique_lock<std::mutex> guard(lock);
+	workDone.wait(guard, [&] { return job->tasksRemaining == 0; });
+	if (currentJob == job)
+	{
+		currentJob.reset();
+	}
+}
+
+void ThreadPool::RunTasks(Job* job)
+{
+	while (true)
+	{
+		int t = job->nextTask++;
+		if (t >= job->taskCount)
+		{
+			return;
+		}
+		job->task(t);
+		std::unique_lock<std::mutex> guard(lock);
+		job->tasksRemaining--;
+		if (job->tasksRemaining == 0)
+		{
+			workDone.notify_all();
+		}
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned int seenGeneration = 0;
+	std::unique_lock<std::mutex> guard(lock);
+	while (true)
+	{
+		workReady.wait(guard, [&] { return stopping || generation != seenGeneration; });
+		if (stopping)
+		{
+			return;
+		}
+		seenGeneration = generation;
+		std::shared_ptr<Job> job = currentJob;
+		if (!job)
+		{
+			continue;	//that call has already finished without this worker
+		}
+		guard.unlock();
+		RunTasks(job.get());
+		job.reset();
+		guard.lock();
+	}
+}
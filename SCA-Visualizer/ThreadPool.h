@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads for running parallel loops. Work is handed out as numbered chunks, so anything a chunk writes
+//to its own output slot comes out the same regardless of how many threads there are or which one ran it
+class ThreadPool
+{
+private:
+	//one ParallelFor call. Workers hold on to the job they picked up, so one that wakes late only ever claims chunks of its
+	//own, long finished, job and never sees the next call's
+	struct Job
+	{
+		std::function<void(int)> task;
+		int taskCount;
+		std::atomic<int> nextTask;
+		int tasksRemaining;	//guarded by lock
+	};
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	std::shared_ptr<Job> currentJob;
+	unsigned int generation;	//incremented for every ParallelFor so sleeping workers can tell there is new work
+	bool stopping;
+	void WorkerLoop();
+	void RunTasks(Job* job);
+public:
+	ThreadPool(unsigned int threadCount);	//0 uses one thread per hardware thread, 1 runs everything on the calling thread
+	~ThreadPool();
+	unsigned int ThreadCount();
+	void ParallelFor(int chunkCount, std::function<void(int)> chunk);	//calls chunk(i) for every i in [0, chunkCount) and returns once they have all finished
+};
@@ -0,0 +1,59 @@
+#include "TileCache.h"
+
+TileCache::TileCache(int capacity, std::function<std::shared_ptr<MapTile>(int)> loader)
+{
+	this->capacity = capacity > 0 ? capacity : 1;
+	this->loader = loader;
+	hits = 0;
+	misses = 0;
+}
+
+std::shared_ptr<const MapTile> TileCache::Get(int key)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto found = tiles.find(key);
+		if (found != tiles.end())
+		{
+			recent.splice(recent.begin(), recent, found->second.second);
+			hits++;
+			return found->second.first;
+		}
+		misses++;
+	}
+	std::shared_ptr<const MapTile> tile = loader(key);
+	std::lock_guard<std::mutex> guard(lock);
+	//another thread may have loaded the same tile in the meantime, keep the first one so every reader shares it
+	auto found = tiles.find(key);
+	if (found != tiles.end())
+	{
+		recent.splice(recent.begin(), recent, found->second.second);
+		return found->second.first;
+	}
+	recent.push_front(key);
+	tiles[key] = std::make_pair(tile, recent.begin());
+	while ((int)tiles.size() > capacity)
+	{
+		tiles.erase(recent.back());
+		recent.pop_back();
+	}
+	return tile;
+}
+
+int TileCache::Size()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return (int)tiles.size();
+}
+
+long long TileCache::Hits()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return hits;
+}
+
+long long TileCache::Misses()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return misses;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//Lookup tables for one square block of a tiled MapLayer. Only the tables that apply to the layer's type are filled
+struct MapTile
+{
+	int x0, y0;	//map position of the tile's first pixel
+	int width, height;	//tiles on the right and top edges of the map can be smaller than the tile size
+	std::vector<unsigned char> roadClasses;
+	std::vector<float> heights;
+	std::vector<float> slopes;
+	std::vector<glm::vec2> gradients;
+};
+
+//Least recently used cache of map tiles, holding at most capacity of them. Missing tiles are built by the loader outside
+//the lock, so several threads can load different tiles at once. Tiles are handed out as shared pointers, which keeps an
+//evicted tile alive for anyone still reading it
+class TileCache
+{
+private:
+	std::mutex lock;
+	int capacity;
+	std::function<std::shared_ptr<MapTile>(int)> loader;
+	std::list<int> recent;	//tile keys, most recently used first
+	std::unordered_map<int, std::pair<std::shared_ptr<const MapTile>, std::list<int>::iterator>> tiles;
+	long long hits, misses;
+public:
+	TileCache(int capacity, std::function<std::shared_ptr<MapTile>(int)> loader);
+	std::shared_ptr<const MapTile> Get(int key);
+	int Size();
+	long long Hits();
+	long long Misses();
+};
@@ -1,12 +1,21 @@
 #pragma once
 
-#include "glm\glm.hpp"
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include <vector>
 
-struct Vertex
+//RGBA, 8 bits a channel from the low byte up, for GL_UNSIGNED_BYTE normalized colour attributes
+inline unsigned int PackColor(glm::vec4 col)
 {
-	glm::vec4 position;
-	glm::vec4 color;
-	Vertex(glm::vec4 pos, glm::vec4 col) { position = pos; color = col; }
+	glm::vec4 c = glm::clamp(col, 0.0f, 1.0f) * 255.0f + 0.5f;
+	return (unsigned int)c.r | ((unsigned int)c.g << 8) | ((unsigned int)c.b << 16) | ((unsigned int)c.a << 24);
+}
+
+struct Vertex	//2D coloured vertex, 12 bytes. The shaders' vec4 position gets z = 0 and w = 1 from GL
+{
+	glm::vec2 position;
+	unsigned int color;
+	Vertex(glm::vec2 pos, glm::vec4 col) { position = pos; color = PackColor(col); }
 };
 
 struct TVertex	//Textured Vertex
@@ -14,4 +23,30 @@ struct TVertex	//Textured Vertex
 	glm::vec4 position;
 	glm::vec2 coord;
 	TVertex(glm::vec4 pos, glm::vec2 coord) { position = pos; this->coord = coord; }
-};
\ No newline at end of file
+};
+
+struct MarkerInstance	//one square marker drawn by instancing, expanded to a quad in the vertex shader
+{
+	glm::vec2 position;	//centre
+	unsigned int color;	//packed by PackColor
+	float size;	//side length
+	MarkerInstance(glm::vec2 pos, glm::vec4 col, float size)
+	{
+		position = pos;
+		color = PackColor(col);
+		this->size = size;
+	}
+};
+
+//uploads to the bound element array buffer, as 16 bit indices when every vertex can be addressed that way. Returns the index type to draw with
+inline GLenum UploadIndices(const std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	if (vertexCount <= 65536)
+	{
+		std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * shortIndices.size(), shortIndices.data(), GL_STATIC_DRAW);
+		return GL_UNSIGNED_SHORT;
+	}
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	return GL_UNSIGNED_INT;
+}
\ No newline at end of file
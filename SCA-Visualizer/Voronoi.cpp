@@ -17,6 +17,7 @@ Voronoi::Voronoi(float minDistanceBetweenSites, std::vector<glm::vec2> points, f
 	xmax = 0, xmin = 0;
 	ymax = 0, ymin = 0;
 	vao = -1, vbo = -1, ibo = -1, indexCount = 0;
+	indexType = GL_UNSIGNED_INT;
 
 	siteIdx = 0;
 	this->minDistanceBetweenSites = minDistanceBetweenSites;
@@ -945,8 +946,8 @@ void Voronoi::BuildMesh()
 	{
 		for (auto& e : site->edges)
 		{
-			Vertex v0 = Vertex(glm::vec4(e->p1, 0.0f, 1.0f), vCol);
-			Vertex v1 = Vertex(glm::vec4(e->p2, 0.0f, 1.0f), vCol);
+			Vertex v0 = Vertex(e->p1, vCol);
+			Vertex v1 = Vertex(e->p2, vCol);
 			vertices.push_back(v0);
 			vertices.push_back(v1);
 			indices.push_back(indexCount);
@@ -961,14 +962,14 @@ void Voronoi::BuildMesh()
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
 	//position
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)0);
 	glEnableVertexAttribArray(0);
 	//color
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)16);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)8);
 	glEnableVertexAttribArray(1);
 	glGenBuffers(1, &ibo);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+	indexType = UploadIndices(indices, vertices.size());
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
@@ -976,6 +977,6 @@ void Voronoi::DrawDiagram()
 {
 	glBindVertexArray(vao);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glDrawElements(GL_LINES, indexCount, GL_UNSIGNED_INT, (void*)0);
+	glDrawElements(GL_LINES, indexCount, indexType, (void*)0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
-#include "glm\glm.hpp"
-#include "glad\glad.h"
+#include "glm/glm.hpp"
+#include "glad/glad.h"
 #include <algorithm>
 #include <vector>
 #include "Settings.h"
@@ -86,8 +86,9 @@ private:
 	HalfEdge* ELrightEnd;
 	GLuint vbo, vao, ibo;
 	int indexCount;
+	GLenum indexType;
 	std::vector<Vertex> vertices;
-	std::vector<int> indices;
+	std::vector<unsigned int> indices;
 
 	//methods
 	void sort(std::vector<glm::vec2> points);